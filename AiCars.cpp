@@ -0,0 +1,77 @@
+// Jonathan Walsh
+#include "AiCars.h"
+#include <algorithm>
+#include <cmath>
+
+void AiCars::Add(float carX, float carZ)
+{
+	x.push_back(carX);
+	z.push_back(carZ);
+	headingX.push_back(0.0f);
+	headingZ.push_back(1.0f);
+	distance.push_back(0.0f);
+}
+
+void AiCars::Clear()
+{
+	x.clear();
+	z.clear();
+	headingX.clear();
+	headingZ.clear();
+	distance.clear();
+}
+
+float AiCars::Yaw(int car) const
+{
+	const float radiansToDegrees = 180.0f / 3.14159265f;
+	return std::atan2(headingX[car], headingZ[car]) * radiansToDegrees;
+}
+
+void AiCars::Update(const RacingLineView& line, bool loop, float topSpeed, float lookAhead, float frameTime, bool moving)
+{
+	Update(line, loop, topSpeed, lookAhead, frameTime, moving, 0, Count());
+}
+
+void AiCars::Update(const RacingLineView& line, bool loop, float topSpeed, float lookAhead, float frameTime, bool moving, int first, int last)
+{
+	if (line.params.count == 0)
+	{
+		return;
+	}
+	int lastSample = line.Sample(line.params.openLength, false);
+	float* carX = x.data();
+	float* carZ = z.data();
+	float* faceX = headingX.data();
+	float* faceZ = headingZ.data();
+	float* along = distance.data();
+	for (int i = first; i < last; i++)
+	{
+		//Catch the distance up with the car, measured along the line at the sample it was last at.
+		int at = line.Sample(along[i], loop);
+		along[i] = at * line.params.spacing + (carX[i] - line.x[at]) * line.headingX[at] + (carZ[i] - line.z[at]) * line.headingZ[at];
+		if (loop && along[i] >= line.params.loopLength)
+		{
+			along[i] -= line.params.loopLength;
+		}
+		at = line.Sample(along[i], loop);
+
+		//Face a point further down the line, the same as LookAt on level ground.  Past the last waypoint the car keeps its heading.
+		if (loop || at < lastSample)
+		{
+			int aim = line.Sample(along[i] + lookAhead, loop);
+			float toX = line.x[aim] - carX[i];
+			float toZ = line.z[aim] - carZ[i];
+			float length = std::sqrt(toX*toX + toZ * toZ);
+			if (length > 0.0f)
+			{
+				faceX[i] = toX / length;
+				faceZ[i] = toZ / length;
+			}
+		}
+
+		//Drive along the local Z.
+		float step = moving ? std::min(topSpeed, line.speed[at]) * frameTime : 0.0f;
+		carX[i] += faceX[i] * step;
+		carZ[i] += faceZ[i] * step;
+	}
+}
@@ -0,0 +1,27 @@
+// Jonathan Walsh
+//The non-player cars.  Every car follows the track's racing line, and each value is kept in its
+//own array so a whole field of cars is updated in one pass down them.
+#pragma once
+#include "RacingLine.h"
+#include <vector>
+
+class AiCars
+{
+public:
+	void Add(float x, float z);
+	void Clear();
+	int Count() const { return int(x.size()); }
+	float Yaw(int car) const; //Degrees around Y, the way the TL-Engine turns the model.
+
+	//Steers every car at the line lookAhead in front of it and, when moving, drives it forward at the
+	//line's speed there, up to topSpeed.  Without loop a car drives straight on past the last waypoint.
+	void Update(const RacingLineView& line, bool loop, float topSpeed, float lookAhead, float frameTime, bool moving);
+	//The same for cars first to last - 1 only.  Cars never read each other, so ranges can run on different threads.
+	void Update(const RacingLineView& line, bool loop, float topSpeed, float lookAhead, float frameTime, bool moving, int first, int last);
+
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<float> headingX; //Unit facing vector, the car's local Z.
+	std::vector<float> headingZ;
+	std::vector<float> distance; //How far along the line each car is, below 0 before the start.
+};
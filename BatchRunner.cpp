@@ -0,0 +1,101 @@
+// Jonathan Walsh
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdio>
+
+RaceResult RunRaceJob(const TrackData& track, const RaceJob& job)
+{
+	//Everything a race touches lives in here, so races on different threads share nothing but the track.
+	RaceSimulation sim(track, job.settings);
+	const RaceDriver& driver = job.driver;
+	NullRaceEngine engine([&sim, &driver](int frame) { return driver(sim, frame); }, job.frameTime, job.maxFrames);
+	RunRace(engine, sim);
+
+	RaceResult result;
+	result.name = job.name;
+	result.finished = sim.Finished();
+	result.lapTime = sim.RaceTime();
+	result.frames = engine.FramesRun();
+	result.health = sim.Player().health;
+	result.damageTaken = sim.Player().damageTaken;
+	result.collisions = sim.Player().collisions;
+	result.checkpointTimes.assign(sim.Laps().Splits(0), sim.Laps().Splits(0) + sim.Laps().GatesPassed(0));
+	return result;
+}
+
+std::vector<RaceResult> RunBatch(const TrackData& track, const std::vector<RaceJob>& jobs, int threadCount, BatchSummary& summary)
+{
+	std::vector<RaceResult> results(jobs.size());
+	auto start = std::chrono::steady_clock::now();
+	{
+		ThreadPool pool(threadCount);
+		summary.threads = pool.ThreadCount();
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			//Each task writes only its own slot, so the results need no locking.
+			pool.Submit([&track, &jobs, &results, i] { results[i] = RunRaceJob(track, jobs[i]); });
+		}
+		pool.WaitIdle();
+	}
+	summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	summary.races = int(results.size());
+	summary.finished = 0;
+	summary.frames = 0;
+	double lapTotal = 0.0;
+	double damageTotal = 0.0;
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const RaceResult& result = results[i];
+		summary.frames += result.frames;
+		damageTotal += result.damageTaken;
+		if (result.finished)
+		{
+			if (summary.finished == 0 || result.lapTime < summary.bestLap)
+			{
+				summary.bestLap = result.lapTime;
+			}
+			if (summary.finished == 0 || result.lapTime > summary.worstLap)
+			{
+				summary.worstLap = result.lapTime;
+			}
+			lapTotal += result.lapTime;
+			summary.finished++;
+		}
+	}
+	summary.meanLap = summary.finished > 0 ? float(lapTotal / summary.finished) : 0.0f;
+	summary.meanDamage = summary.races > 0 ? float(damageTotal / summary.races) : 0.0f;
+	return results;
+}
+
+void PrintBatchReport(const std::vector<RaceResult>& results, const BatchSummary& summary, bool everyRace)
+{
+	if (everyRace)
+	{
+		printf("%-12s %8s %9s %7s %7s %7s  %s\n", "race", "finished", "lap (s)", "health", "damage", "hits", "checkpoints (s)");
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const RaceResult& result = results[i];
+			printf("%-12s %8s %9.3f %7d %7d %7d ", result.name.c_str(), result.finished ? "yes" : "no",
+				result.lapTime, result.health, result.damageTaken, result.collisions);
+			for (size_t j = 0; j < result.checkpointTimes.size(); j++)
+			{
+				printf(" %.2f", result.checkpointTimes[j]);
+			}
+			printf("\n");
+		}
+		printf("\n");
+	}
+
+	printf("races: %d on %d threads\n", summary.races, summary.threads);
+	printf("finished: %d\n", summary.finished);
+	printf("lap time best/mean/worst: %.3f / %.3f / %.3f s\n", summary.bestLap, summary.meanLap, summary.worstLap);
+	printf("mean damage: %.1f\n", summary.meanDamage);
+	printf("wall time: %.3f s\n", summary.wallSeconds);
+	if (summary.wallSeconds > 0.0)
+	{
+		printf("races per second: %.1f\n", summary.races / summary.wallSeconds);
+		printf("frames per second: %.0f\n", summary.frames / summary.wallSeconds);
+	}
+}
@@ -0,0 +1,47 @@
+// Jonathan Walsh
+//Runs many independent headless races at once on a work-stealing thread pool and
+//collects lap times, damage and checkpoint timings from each.
+#pragma once
+#include "NullRaceEngine.h"
+#include <string>
+#include <vector>
+
+typedef std::function<RaceInput(const RaceSimulation& sim, int frame)> RaceDriver; //Controls for one race.
+
+struct RaceJob
+{
+	std::string name;
+	RaceSettings settings;
+	RaceDriver driver = AutopilotInput;
+	float frameTime = 1.0f / 60.0f;
+	int maxFrames = 60 * 60 * 5;
+};
+
+struct RaceResult
+{
+	std::string name;
+	bool finished = false;
+	float lapTime = 0.0f; //Race time when the finish was crossed, or when the race was stopped.
+	int frames = 0;
+	int health = 0;
+	int damageTaken = 0;
+	int collisions = 0;
+	std::vector<float> checkpointTimes;
+};
+
+struct BatchSummary
+{
+	int races = 0;
+	int finished = 0;
+	float bestLap = 0.0f;
+	float meanLap = 0.0f; //Finished races only.
+	float worstLap = 0.0f;
+	float meanDamage = 0.0f;
+	long long frames = 0;
+	double wallSeconds = 0.0;
+	int threads = 0;
+};
+
+RaceResult RunRaceJob(const TrackData& track, const RaceJob& job); //Runs one race on the calling thread.
+std::vector<RaceResult> RunBatch(const TrackData& track, const std::vector<RaceJob>& jobs, int threadCount, BatchSummary& summary);
+void PrintBatchReport(const std::vector<RaceResult>& results, const BatchSummary& summary, bool everyRace);
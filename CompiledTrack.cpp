@@ -0,0 +1,8 @@
+// Jonathan Walsh
+#include "CompiledTrack.h"
+
+const TrackData& CompiledDefaultTrack()
+{
+	static const CompiledTrack<defaultTrackSource> track;
+	return track.Data();
+}
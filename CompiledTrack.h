@@ -0,0 +1,279 @@
+// Jonathan Walsh
+//Tracks baked by the compiler.  CompiledTrackTables works out, as constexpr arrays, what BakedTrack
+//builds when a track loads: the obstacle stores grown by the car's radius and sorted into grid
+//order, and the broadphase grids.  They sit in the program's read-only data, so a track written
+//into the program starts with nothing to build but its racing line, which needs square roots and
+//arc cosines the compiler cannot work out.  The sums are the same ones SpatialGrid::Build and the
+//obstacle stores use, so a compiled track collides exactly like the same track baked or mapped.
+#pragma once
+#include "TrackData.h"
+#include <array>
+#include <cstddef>
+
+//A grid's obstacle order and cell starts, for Cells cells.
+template <size_t Count, int Cells>
+struct CompiledGrid
+{
+	std::array<int, Count> order; //Obstacle indices sorted by cell.
+	std::array<int, Cells + 1> cellStart;
+};
+
+template <size_t Count>
+struct CompiledBoxes
+{
+	std::array<float, Count> x;
+	std::array<float, Count> z;
+	std::array<float, Count> halfWidth;
+	std::array<float, Count> halfDepth;
+	std::array<float, Count> minX;
+	std::array<float, Count> maxX;
+	std::array<float, Count> minZ;
+	std::array<float, Count> maxZ;
+};
+
+template <size_t Count>
+struct CompiledSpheres
+{
+	std::array<float, Count> x;
+	std::array<float, Count> z;
+	std::array<float, Count> radius;
+	std::array<float, Count> touchSq;
+};
+
+//Same as BoxObstacles::Add for each box, in the track's order.
+template <size_t Count>
+constexpr CompiledBoxes<Count> CompileBoxes(const std::array<float, Count>& x, const std::array<float, Count>& z, float width, float depth)
+{
+	CompiledBoxes<Count> boxes = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		boxes.x[i] = x[i];
+		boxes.z[i] = z[i];
+		boxes.halfWidth[i] = width / 2;
+		boxes.halfDepth[i] = depth / 2;
+		boxes.minX[i] = GrownMin(x[i], width / 2);
+		boxes.maxX[i] = GrownMax(x[i], width / 2);
+		boxes.minZ[i] = GrownMin(z[i], depth / 2);
+		boxes.maxZ[i] = GrownMax(z[i], depth / 2);
+	}
+	return boxes;
+}
+
+template <size_t Count>
+constexpr CompiledSpheres<Count> CompileSpheres(const std::array<float, Count>& x, const std::array<float, Count>& z, float radius)
+{
+	CompiledSpheres<Count> spheres = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		spheres.x[i] = x[i];
+		spheres.z[i] = z[i];
+		spheres.radius[i] = radius;
+		spheres.touchSq[i] = TouchDistanceSq(radius);
+	}
+	return spheres;
+}
+
+template <size_t Count>
+constexpr float CompiledReach(const CompiledBoxes<Count>& boxes)
+{
+	float reach = 0.0f;
+	for (size_t i = 0; i < Count; i++)
+	{
+		reach = std::max(reach, std::max(boxes.halfWidth[i], boxes.halfDepth[i]));
+	}
+	return reach;
+}
+
+template <size_t Count>
+constexpr float CompiledReach(const CompiledSpheres<Count>& spheres)
+{
+	float reach = 0.0f;
+	for (size_t i = 0; i < Count; i++)
+	{
+		reach = std::max(reach, spheres.radius[i]);
+	}
+	return reach;
+}
+
+//The grid SpatialGrid::Build would make: over the obstacle centres, the cell size doubled until it fits.
+template <size_t Count>
+constexpr GridParams CompiledGridParams(const std::array<float, Count>& x, const std::array<float, Count>& z, float reach, float cellSize)
+{
+	GridParams params = { 0.0f, 0.0f, cellSize, reach, 0, 0 };
+	if (Count == 0)
+	{
+		return params;
+	}
+	float minX = x[0], maxX = x[0], minZ = z[0], maxZ = z[0];
+	for (size_t i = 1; i < Count; i++)
+	{
+		minX = std::min(minX, x[i]);
+		maxX = std::max(maxX, x[i]);
+		minZ = std::min(minZ, z[i]);
+		maxZ = std::max(maxZ, z[i]);
+	}
+	params.originX = minX;
+	params.originZ = minZ;
+	for (;;)
+	{
+		params.cellsX = int((maxX - minX) / params.cellSize) + 1;
+		params.cellsZ = int((maxZ - minZ) / params.cellSize) + 1;
+		if (double(params.cellsX) * params.cellsZ <= maxGridCells)
+		{
+			break;
+		}
+		params.cellSize *= 2.0f;
+	}
+	return params;
+}
+
+//The same counting sort by cell as SpatialGrid::Build.  Centres are never below the origin, so
+//truncating matches its floor.
+template <int Cells, size_t Count>
+constexpr CompiledGrid<Count, Cells> CompileGrid(const GridParams& params, const std::array<float, Count>& x, const std::array<float, Count>& z)
+{
+	CompiledGrid<Count, Cells> grid = {};
+	std::array<int, Count> cellOf = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		int cellX = std::min(int((x[i] - params.originX) / params.cellSize), params.cellsX - 1);
+		int cellZ = std::min(int((z[i] - params.originZ) / params.cellSize), params.cellsZ - 1);
+		cellOf[i] = cellZ * params.cellsX + cellX;
+		grid.cellStart[cellOf[i] + 1]++;
+	}
+	for (int c = 1; c <= Cells; c++)
+	{
+		grid.cellStart[c] += grid.cellStart[c - 1];
+	}
+	std::array<int, Cells + 1> fill = grid.cellStart;
+	for (size_t i = 0; i < Count; i++)
+	{
+		grid.order[fill[cellOf[i]]++] = int(i);
+	}
+	return grid;
+}
+
+template <size_t Count>
+constexpr CompiledBoxes<Count> SortedBoxes(const CompiledBoxes<Count>& boxes, const std::array<int, Count>& order)
+{
+	CompiledBoxes<Count> sorted = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		int from = order[i];
+		sorted.x[i] = boxes.x[from];
+		sorted.z[i] = boxes.z[from];
+		sorted.halfWidth[i] = boxes.halfWidth[from];
+		sorted.halfDepth[i] = boxes.halfDepth[from];
+		sorted.minX[i] = boxes.minX[from];
+		sorted.maxX[i] = boxes.maxX[from];
+		sorted.minZ[i] = boxes.minZ[from];
+		sorted.maxZ[i] = boxes.maxZ[from];
+	}
+	return sorted;
+}
+
+template <size_t Count>
+constexpr CompiledSpheres<Count> SortedSpheres(const CompiledSpheres<Count>& spheres, const std::array<int, Count>& order)
+{
+	CompiledSpheres<Count> sorted = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		int from = order[i];
+		sorted.x[i] = spheres.x[from];
+		sorted.z[i] = spheres.z[from];
+		sorted.radius[i] = spheres.radius[from];
+		sorted.touchSq[i] = spheres.touchSq[from];
+	}
+	return sorted;
+}
+
+//Everything BakedTrack builds for Source, bar the racing line, with the default cell size.
+template <const auto& Source>
+struct CompiledTrackTables
+{
+	static constexpr CompiledBoxes<Source.wallX.size()> trackWalls = CompileBoxes(Source.wallX, Source.wallZ, wallWidth, wallDepth);
+	static constexpr GridParams wallParams = CompiledGridParams(Source.wallX, Source.wallZ, CompiledReach(trackWalls), defaultCellSize);
+	static constexpr auto wallGrid = CompileGrid<wallParams.cellsX * wallParams.cellsZ>(wallParams, Source.wallX, Source.wallZ);
+	static constexpr auto walls = SortedBoxes(trackWalls, wallGrid.order);
+
+	static constexpr CompiledSpheres<Source.strutX.size()> trackStruts = CompileSpheres(Source.strutX, Source.strutZ, strutRad);
+	static constexpr GridParams strutParams = CompiledGridParams(Source.strutX, Source.strutZ, CompiledReach(trackStruts), defaultCellSize);
+	static constexpr auto strutGrid = CompileGrid<strutParams.cellsX * strutParams.cellsZ>(strutParams, Source.strutX, Source.strutZ);
+	static constexpr auto struts = SortedSpheres(trackStruts, strutGrid.order);
+
+	static constexpr CompiledSpheres<Source.tankX.size()> trackTanks = CompileSpheres(Source.tankX, Source.tankZ, tankRad);
+	static constexpr GridParams tankParams = CompiledGridParams(Source.tankX, Source.tankZ, CompiledReach(trackTanks), defaultCellSize);
+	static constexpr auto tankGrid = CompileGrid<tankParams.cellsX * tankParams.cellsZ>(tankParams, Source.tankX, Source.tankZ);
+	static constexpr auto tanks = SortedSpheres(trackTanks, tankGrid.order);
+
+	static_assert(wallGrid.cellStart.back() == int(Source.wallX.size()), "Every wall must be in the grid");
+	static_assert(strutGrid.cellStart.back() == int(Source.strutX.size()), "Every strut must be in the grid");
+	static_assert(tankGrid.cellStart.back() == int(Source.tankX.size()), "Every tank must be in the grid");
+};
+
+//A compiled track ready to race on.  Its TrackData points at the source and the constexpr tables.
+template <const auto& Source>
+class CompiledTrack
+{
+public:
+	CompiledTrack()
+	{
+		typedef CompiledTrackTables<Source> Tables;
+		racingLine.Build(Source.waypointX.data(), Source.waypointZ.data(), int(Source.waypointX.size()));
+
+		data.checkpointX = ArrayOf(Source.checkpointX);
+		data.checkpointZ = ArrayOf(Source.checkpointZ);
+		data.checkpointRotation = ArrayOf(Source.checkpointRotation);
+		data.strutX = ArrayOf(Source.strutX);
+		data.strutZ = ArrayOf(Source.strutZ);
+		data.isleX = ArrayOf(Source.isleX);
+		data.isleZ = ArrayOf(Source.isleZ);
+		data.wallX = ArrayOf(Source.wallX);
+		data.wallZ = ArrayOf(Source.wallZ);
+		data.tankX = ArrayOf(Source.tankX);
+		data.tankY = ArrayOf(Source.tankY);
+		data.tankZ = ArrayOf(Source.tankZ);
+		data.tankRotation = ArrayOf(Source.tankRotation);
+		data.waypointX = ArrayOf(Source.waypointX);
+		data.waypointZ = ArrayOf(Source.waypointZ);
+
+		const auto& walls = Tables::walls;
+		data.walls = { walls.x.data(), walls.z.data(), walls.halfWidth.data(), walls.halfDepth.data(),
+			walls.minX.data(), walls.maxX.data(), walls.minZ.data(), walls.maxZ.data(), int(walls.x.size()) };
+		data.struts = SphereView(Tables::struts);
+		data.tanks = SphereView(Tables::tanks);
+		data.wallGrid = GridOf(Tables::wallParams, Tables::wallGrid.cellStart);
+		data.strutGrid = GridOf(Tables::strutParams, Tables::strutGrid.cellStart);
+		data.tankGrid = GridOf(Tables::tankParams, Tables::tankGrid.cellStart);
+		data.racingLine = racingLine.View();
+	}
+
+	CompiledTrack(const CompiledTrack&) = delete; //TrackData points into this object.
+	CompiledTrack& operator=(const CompiledTrack&) = delete;
+
+	const TrackData& Data() const { return data; }
+
+private:
+	template <size_t Count>
+	static TrackArray ArrayOf(const std::array<float, Count>& values)
+	{
+		return { values.data(), int(Count) };
+	}
+
+	template <size_t Count>
+	static SphereObstacleView SphereView(const CompiledSpheres<Count>& spheres)
+	{
+		return { spheres.x.data(), spheres.z.data(), spheres.radius.data(), spheres.touchSq.data(), int(Count) };
+	}
+
+	template <size_t Starts>
+	static GridView GridOf(const GridParams& params, const std::array<int, Starts>& cellStart)
+	{
+		return { params, Starts > 1 ? cellStart.data() : nullptr }; //An empty grid has no cells, as with SpatialGrid.
+	}
+
+	RacingLine racingLine;
+	TrackData data = {};
+};
+
+const TrackData& CompiledDefaultTrack(); //defaultTrackSource, built on first use.
@@ -0,0 +1,224 @@
+// Jonathan Walsh
+#include "CullingBvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const int leafItems = 4; //Items a leaf holds before it is split.
+	const int maxDepth = 48; //The split is at the median, so this is only reached by millions of items at one spot.
+	const float degreesToRadians = 3.14159265f / 180.0f;
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	void SetPlane(float* plane, float nx, float ny, float nz, const float* through)
+	{
+		float length = std::sqrt(nx*nx + ny * ny + nz * nz);
+		plane[0] = nx / length;
+		plane[1] = ny / length;
+		plane[2] = nz / length;
+		plane[3] = -(plane[0] * through[0] + plane[1] * through[1] + plane[2] * through[2]);
+	}
+}
+
+ViewFrustum ViewFrustum::FromCamera(const float matrix[16], float fovY, float aspect, float nearClip, float farClip)
+{
+	//The axes may carry the camera's scale, so they are made unit length first.
+	float axis[3][3];
+	for (int row = 0; row < 3; row++)
+	{
+		const float* m = matrix + row * 4;
+		float length = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+		for (int i = 0; i < 3; i++)
+		{
+			axis[row][i] = length > 0.0f ? m[i] / length : 0.0f;
+		}
+	}
+	const float* right = axis[0];
+	const float* up = axis[1];
+	const float* forward = axis[2];
+	const float* position = matrix + 12;
+
+	//A side plane leans in from the camera by half the field of view.
+	float tanY = std::tan(fovY * degreesToRadians / 2);
+	float tanX = tanY * aspect;
+	ViewFrustum frustum;
+	SetPlane(frustum.planes[0], right[0] + forward[0] * tanX, right[1] + forward[1] * tanX, right[2] + forward[2] * tanX, position);
+	SetPlane(frustum.planes[1], -right[0] + forward[0] * tanX, -right[1] + forward[1] * tanX, -right[2] + forward[2] * tanX, position);
+	SetPlane(frustum.planes[2], up[0] + forward[0] * tanY, up[1] + forward[1] * tanY, up[2] + forward[2] * tanY, position);
+	SetPlane(frustum.planes[3], -up[0] + forward[0] * tanY, -up[1] + forward[1] * tanY, -up[2] + forward[2] * tanY, position);
+	float nearPoint[3];
+	float farPoint[3];
+	for (int i = 0; i < 3; i++)
+	{
+		nearPoint[i] = position[i] + forward[i] * nearClip;
+		farPoint[i] = position[i] + forward[i] * farClip;
+	}
+	SetPlane(frustum.planes[4], forward[0], forward[1], forward[2], nearPoint);
+	SetPlane(frustum.planes[5], -forward[0], -forward[1], -forward[2], farPoint);
+	return frustum;
+}
+
+ViewFrustum::Overlap ViewFrustum::TestBox(const float boxMin[3], const float boxMax[3]) const
+{
+	Overlap overlap = Inside;
+	for (int p = 0; p < 6; p++)
+	{
+		//The corners furthest along the plane's normal and furthest against it.
+		const float* plane = planes[p];
+		float furthest = plane[3];
+		float nearest = plane[3];
+		for (int i = 0; i < 3; i++)
+		{
+			furthest += plane[i] * (plane[i] >= 0.0f ? boxMax[i] : boxMin[i]);
+			nearest += plane[i] * (plane[i] >= 0.0f ? boxMin[i] : boxMax[i]);
+		}
+		if (furthest < 0.0f)
+		{
+			return Outside;
+		}
+		if (nearest < 0.0f)
+		{
+			overlap = Partly;
+		}
+	}
+	return overlap;
+}
+
+bool ViewFrustum::TestSphere(float sx, float sy, float sz, float sr) const
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const float* plane = planes[p];
+		if (plane[0] * sx + plane[1] * sy + plane[2] * sz + plane[3] < -sr)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void CullingBvh::Build(const float* itemX, const float* itemY, const float* itemZ, const float* itemRadius, int count)
+{
+	x.assign(itemX, itemX + count);
+	y.assign(itemY, itemY + count);
+	z.assign(itemZ, itemZ + count);
+	radius.assign(itemRadius, itemRadius + count);
+	order.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	nodes.clear();
+	if (count == 0)
+	{
+		return;
+	}
+	nodes.reserve(size_t(count) * 2);
+	nodes.push_back(BvhNode());
+	BuildNode(0, 0, count, 0);
+}
+
+void CullingBvh::BuildNode(int node, int first, int count, int depth)
+{
+	//The box round every sphere in the node, and the box round their centres to choose the split.
+	float boundsMin[3] = { infinity, infinity, infinity };
+	float boundsMax[3] = { -infinity, -infinity, -infinity };
+	float centreMin[3] = { infinity, infinity, infinity };
+	float centreMax[3] = { -infinity, -infinity, -infinity };
+	for (int i = first; i < first + count; i++)
+	{
+		int item = order[i];
+		float centre[3] = { x[item], y[item], z[item] };
+		for (int a = 0; a < 3; a++)
+		{
+			boundsMin[a] = std::min(boundsMin[a], centre[a] - radius[item]);
+			boundsMax[a] = std::max(boundsMax[a], centre[a] + radius[item]);
+			centreMin[a] = std::min(centreMin[a], centre[a]);
+			centreMax[a] = std::max(centreMax[a], centre[a]);
+		}
+	}
+	BvhNode& built = nodes[node];
+	std::copy(boundsMin, boundsMin + 3, built.boundsMin);
+	std::copy(boundsMax, boundsMax + 3, built.boundsMax);
+	built.first = first;
+	built.count = count;
+	built.left = 0;
+	if (count <= leafItems || depth >= maxDepth)
+	{
+		return;
+	}
+
+	//Half the items either side of the middle one along the widest spread of centres.
+	int axis = 0;
+	for (int a = 1; a < 3; a++)
+	{
+		if (centreMax[a] - centreMin[a] > centreMax[axis] - centreMin[axis])
+		{
+			axis = a;
+		}
+	}
+	const float* key = axis == 0 ? x.data() : (axis == 1 ? y.data() : z.data());
+	int half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+		[key](int a, int b) { return key[a] < key[b]; });
+
+	//Pushing the children may move the nodes, so the parent is found again by index.
+	int left = int(nodes.size());
+	nodes[node].left = left;
+	nodes.push_back(BvhNode());
+	nodes.push_back(BvhNode());
+	BuildNode(left, first, half, depth + 1);
+	BuildNode(left + 1, first + half, count - half, depth + 1);
+}
+
+void CullingBvh::Query(const ViewFrustum& frustum, std::vector<int>& visible) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+	int stack[maxDepth * 2 + 2];
+	int size = 0;
+	stack[size++] = 0;
+	while (size > 0)
+	{
+		const BvhNode& node = nodes[stack[--size]];
+		ViewFrustum::Overlap overlap = frustum.TestBox(node.boundsMin, node.boundsMax);
+		if (overlap == ViewFrustum::Outside)
+		{
+			continue;
+		}
+		if (overlap == ViewFrustum::Inside)
+		{
+			visible.insert(visible.end(), order.begin() + node.first, order.begin() + node.first + node.count);
+			continue;
+		}
+		if (node.left != 0)
+		{
+			stack[size++] = node.left;
+			stack[size++] = node.left + 1;
+			continue;
+		}
+		for (int i = node.first; i < node.first + node.count; i++)
+		{
+			int item = order[i];
+			if (frustum.TestSphere(x[item], y[item], z[item], radius[item]))
+			{
+				visible.push_back(item);
+			}
+		}
+	}
+}
+
+void VisibleSet::Reset(int count)
+{
+	frame = 1;
+	seenFrame.assign(count, frame);
+	shown.reserve(count);
+	shown.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		shown[i] = i;
+	}
+}
@@ -0,0 +1,93 @@
+// Jonathan Walsh
+//Visibility culling for the track's models.  A bounding volume hierarchy is built over every
+//static model's bounding sphere when the track loads, and each frame it is walked against the
+//camera's view: a branch wholly out of view is skipped and one wholly in view is taken without
+//testing its models, so the cost follows what is on screen rather than the size of the track.
+//Nothing here needs the TL-Engine.
+#pragma once
+#include <cstdint>
+#include <vector>
+
+//The camera's view as six planes facing inwards: left, right, bottom, top, near and far.
+struct ViewFrustum
+{
+	enum Overlap { Outside, Partly, Inside };
+
+	float planes[6][4]; //x, y, z and d.  A point is on the inside when x*px + y*py + z*pz + d >= 0.
+
+	//From a TL-Engine world matrix (rows are the local X, Y and Z axes, then the position), the
+	//vertical field of view in degrees and the width over the height of the view.
+	static ViewFrustum FromCamera(const float matrix[16], float fovY, float aspect, float nearClip, float farClip);
+
+	Overlap TestBox(const float boxMin[3], const float boxMax[3]) const;
+	bool TestSphere(float x, float y, float z, float radius) const;
+};
+
+struct BvhNode
+{
+	float boundsMin[3];
+	float boundsMax[3];
+	int first; //The node's items are order[first] to order[first + count - 1].
+	int count;
+	int left; //Children are left and left + 1, or 0 for a leaf.
+};
+
+class CullingBvh
+{
+public:
+	//Builds the tree over count spheres.  Items are numbered in the order given.
+	void Build(const float* x, const float* y, const float* z, const float* radius, int count);
+	int Count() const { return int(order.size()); }
+	int NodeCount() const { return int(nodes.size()); }
+	const BvhNode& Node(int i) const { return nodes[i]; }
+
+	//Appends every item in view to visible, in no particular order.
+	void Query(const ViewFrustum& frustum, std::vector<int>& visible) const;
+
+private:
+	void BuildNode(int node, int first, int count, int depth);
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radius;
+	std::vector<int> order; //Items sorted so every node's items are side by side.
+	std::vector<BvhNode> nodes; //The root is node 0.
+};
+
+//Which items were shown last frame, so only the ones that came into or went out of view are
+//touched.  Every item starts shown.
+class VisibleSet
+{
+public:
+	void Reset(int count);
+	int Shown() const { return int(shown.size()); }
+
+	//Calls changed(item, show) for each item whose visibility differs from last time.
+	template <class Changed>
+	void Update(const std::vector<int>& visible, Changed changed)
+	{
+		frame++;
+		for (int item : visible)
+		{
+			if (seenFrame[item] != frame - 1)
+			{
+				changed(item, true);
+			}
+			seenFrame[item] = frame;
+		}
+		for (int item : shown)
+		{
+			if (seenFrame[item] != frame)
+			{
+				changed(item, false);
+			}
+		}
+		shown.assign(visible.begin(), visible.end()); //Room for every item was reserved in Reset.
+	}
+
+private:
+	std::vector<uint32_t> seenFrame; //The last frame each item was in view.
+	std::vector<int> shown;
+	uint32_t frame = 0;
+};
@@ -0,0 +1,181 @@
+// Jonathan Walsh
+#include "FrameProfiler.h"
+
+#if RACE_PROFILE
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_RDTSC 1
+#endif
+
+thread_local FrameProfiler* FrameProfiler::current = nullptr;
+
+namespace
+{
+	double SteadySeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	float Percentile(std::vector<float>& values, float fraction)
+	{
+		size_t index = std::min(values.size() - 1, size_t(fraction * (values.size() - 1) + 0.5f));
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+}
+
+FrameProfiler::FrameProfiler()
+	: framesWritten(0), startTicks(Now()), startSeconds(SteadySeconds())
+{
+	memset(&frame, 0, sizeof(frame));
+	memset(history, 0, sizeof(history));
+}
+
+void FrameProfiler::Install(FrameProfiler* profiler)
+{
+	current = profiler;
+}
+
+uint64_t FrameProfiler::Now()
+{
+#ifdef PROFILE_RDTSC
+	return __rdtsc();
+#else
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void FrameProfiler::EndFrame()
+{
+	//Only this thread writes, so the slot is filled in first and the count published after it.
+	uint64_t written = framesWritten.load(std::memory_order_relaxed);
+	history[written % profileHistory] = frame;
+	framesWritten.store(written + 1, std::memory_order_release);
+	memset(&frame, 0, sizeof(frame));
+}
+
+int FrameProfiler::Snapshot(ProfileFrame* out, int maxFrames) const
+{
+	uint64_t written = framesWritten.load(std::memory_order_acquire);
+	uint64_t count = std::min<uint64_t>(std::min<uint64_t>(written, profileHistory), uint64_t(maxFrames));
+	uint64_t first = written - count;
+	for (uint64_t i = 0; i < count; i++)
+	{
+		out[i] = history[(first + i) % profileHistory];
+	}
+
+	//Frames the writer lapped while we were copying may be torn, so drop them.  That includes the
+	//frame it may be part way through writing now, writtenAfter, which goes in the slot of frame
+	//writtenAfter - profileHistory before the count says so.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t writtenAfter = framesWritten.load(std::memory_order_relaxed);
+	uint64_t firstSafe = writtenAfter + 1 > profileHistory ? writtenAfter + 1 - profileHistory : 0;
+	uint64_t torn = firstSafe > first ? firstSafe - first : 0;
+	if (torn >= count)
+	{
+		return 0;
+	}
+	if (torn > 0)
+	{
+		memmove(out, out + torn, sizeof(ProfileFrame) * size_t(count - torn));
+	}
+	return int(count - torn);
+}
+
+double FrameProfiler::MicrosecondsPerTick() const
+{
+#ifdef PROFILE_RDTSC
+	double seconds = SteadySeconds() - startSeconds;
+	uint64_t ticks = Now() - startTicks;
+	return ticks > 0 ? seconds * 1e6 / double(ticks) : 0.0;
+#else
+	return 1e-3; //steady_clock nanoseconds.
+#endif
+}
+
+void FrameProfiler::Stats(PhaseStats* out) const
+{
+	std::vector<ProfileFrame> frames(profileHistory);
+	frames.resize(Snapshot(frames.data(), profileHistory));
+	double scale = MicrosecondsPerTick();
+
+	std::vector<float> values(frames.size());
+	for (int phase = 0; phase < PhaseCount; phase++)
+	{
+		PhaseStats& stats = out[phase];
+		memset(&stats, 0, sizeof(stats));
+		if (frames.empty())
+		{
+			continue;
+		}
+		double total = 0.0;
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			values[i] = float(frames[i].ticks[phase] * scale);
+			total += values[i];
+			stats.max = std::max(stats.max, values[i]);
+		}
+		stats.mean = float(total / frames.size());
+		stats.p50 = Percentile(values, 0.50f);
+		stats.p95 = Percentile(values, 0.95f);
+		stats.p99 = Percentile(values, 0.99f);
+	}
+}
+
+bool FrameProfiler::ExportCsv(const std::string& path) const
+{
+	PhaseStats stats[PhaseCount];
+	Stats(stats);
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	fprintf(file, "phase,p50_us,p95_us,p99_us,mean_us,max_us\n");
+	for (int phase = 0; phase < PhaseCount; phase++)
+	{
+		fprintf(file, "%s,%.3f,%.3f,%.3f,%.3f,%.3f\n", PhaseName(phase),
+			stats[phase].p50, stats[phase].p95, stats[phase].p99, stats[phase].mean, stats[phase].max);
+	}
+	return fclose(file) == 0;
+}
+
+bool FrameProfiler::ExportJson(const std::string& path) const
+{
+	PhaseStats stats[PhaseCount];
+	Stats(stats);
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		return false;
+	}
+	fprintf(file, "{\n  \"frames\": %d,\n  \"phases\": {\n", int(std::min<uint64_t>(framesWritten.load(), profileHistory)));
+	for (int phase = 0; phase < PhaseCount; phase++)
+	{
+		fprintf(file, "    \"%s\": { \"p50_us\": %.3f, \"p95_us\": %.3f, \"p99_us\": %.3f, \"mean_us\": %.3f, \"max_us\": %.3f }%s\n",
+			PhaseName(phase), stats[phase].p50, stats[phase].p95, stats[phase].p99, stats[phase].mean, stats[phase].max,
+			phase + 1 < PhaseCount ? "," : "");
+	}
+	fprintf(file, "  }\n}\n");
+	return fclose(file) == 0;
+}
+
+const char* FrameProfiler::PhaseName(int phase)
+{
+	const char* names[PhaseCount] = {
+		"input", "physics", "checkpoints", "sweep", "walls", "struts", "tanks", "car_collision", "contacts",
+		"boost", "ai", "telemetry", "camera", "culling", "hud", "draw_scene"
+	};
+	return phase >= 0 && phase < PhaseCount ? names[phase] : "unknown";
+}
+
+#endif
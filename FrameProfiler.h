@@ -0,0 +1,115 @@
+// Jonathan Walsh
+//Per-phase frame profiler.  PROFILE_SCOPE(phase) times a block and adds it to the current
+//frame, PROFILE_FRAME_END() files the frame into a ring buffer of recent history.  Only the
+//thread that called FrameProfiler::Install records anything, so batch races on worker threads
+//are never timed.  Set RACE_PROFILE to 0 (the default when NDEBUG is defined, as in release
+//builds) and every macro and the profiler itself compile away to nothing.
+#pragma once
+
+#ifndef RACE_PROFILE
+#ifdef NDEBUG
+#define RACE_PROFILE 0
+#else
+#define RACE_PROFILE 1
+#endif
+#endif
+
+enum ProfilePhase
+{
+	PhaseInput, PhasePhysics, PhaseCheckpoints, PhaseSweep, PhaseWalls, PhaseStruts, PhaseTanks, PhaseCarCollision, PhaseContacts,
+	PhaseBoost, PhaseAi, PhaseTelemetry, PhaseCamera, PhaseCulling, PhaseHud, PhaseDrawScene, PhaseCount
+};
+
+#if RACE_PROFILE
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+const int profileHistory = 1024; //Frames kept in the ring buffer.
+
+struct ProfileFrame
+{
+	uint64_t ticks[PhaseCount];
+};
+
+//Percentiles for one phase, in microseconds.
+struct PhaseStats
+{
+	float p50;
+	float p95;
+	float p99;
+	float mean;
+	float max;
+};
+
+class FrameProfiler
+{
+public:
+	FrameProfiler();
+
+	//Makes this profiler record on the calling thread, pass nullptr to stop.
+	static void Install(FrameProfiler* profiler);
+	static FrameProfiler* Current() { return current; }
+
+	static uint64_t Now(); //Timestamp counter where there is one, steady_clock otherwise.
+
+	void Add(ProfilePhase phase, uint64_t ticks) { frame.ticks[phase] += ticks; }
+	void EndFrame(); //Publishes the frame just timed and starts the next.
+
+	//Copies up to maxFrames of the newest frames, oldest first, and returns how many it copied.
+	//Safe to call from another thread while frames are being recorded; a full ring then gives at
+	//most profileHistory - 1, as the oldest slot is the one the next frame is written into.
+	int Snapshot(ProfileFrame* out, int maxFrames) const;
+
+	void Stats(PhaseStats* out) const; //One entry per phase over the frames in the buffer.
+	bool ExportCsv(const std::string& path) const;
+	bool ExportJson(const std::string& path) const;
+
+	static const char* PhaseName(int phase);
+
+private:
+	double MicrosecondsPerTick() const;
+
+	static thread_local FrameProfiler* current;
+
+	ProfileFrame frame;
+	ProfileFrame history[profileHistory];
+	std::atomic<uint64_t> framesWritten; //history[n % profileHistory] holds frame n.
+
+	//Two readings of both clocks, used to turn timestamp ticks into microseconds.
+	uint64_t startTicks;
+	double startSeconds;
+};
+
+class ScopedPhaseTimer
+{
+public:
+	explicit ScopedPhaseTimer(ProfilePhase phase)
+		: profiler(FrameProfiler::Current()), phase(phase), start(profiler != nullptr ? FrameProfiler::Now() : 0)
+	{
+	}
+	~ScopedPhaseTimer()
+	{
+		if (profiler != nullptr)
+		{
+			profiler->Add(phase, FrameProfiler::Now() - start);
+		}
+	}
+
+private:
+	FrameProfiler* profiler;
+	ProfilePhase phase;
+	uint64_t start;
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(phase) ScopedPhaseTimer PROFILE_JOIN(profileTimer, __LINE__)(phase)
+#define PROFILE_FRAME_END() do { if (FrameProfiler::Current() != nullptr) FrameProfiler::Current()->EndFrame(); } while (false)
+
+#else
+
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_FRAME_END() ((void)0)
+
+#endif
@@ -0,0 +1,361 @@
+// Jonathan Walsh
+#include "GhostLap.h"
+#include "MappedFile.h"
+#include "TrackFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const int gridSteps = 65536;
+	const size_t lapReserve = 4096; //Bytes set aside for a lap up front, about a minute and a half of driving.
+
+	void Extend(const TrackArray& x, const TrackArray& z, float& minX, float& minZ, float& maxX, float& maxZ)
+	{
+		for (int i = 0; i < x.Count(); i++)
+		{
+			minX = std::min(minX, x[i]);
+			maxX = std::max(maxX, x[i]);
+			minZ = std::min(minZ, z[i]);
+			maxZ = std::max(maxZ, z[i]);
+		}
+	}
+
+	//Yaw steps moved, taken the short way round.
+	int32_t WrapYaw(int32_t change)
+	{
+		return ((change + ghostYawSteps / 2) & (ghostYawSteps - 1)) - ghostYawSteps / 2;
+	}
+
+	//Reads one zigzag varint, or returns false at the end of the data.
+	bool ReadSigned(const uint8_t* data, size_t size, size_t& at, int32_t& value)
+	{
+		uint32_t bits = 0;
+		for (int shift = 0; shift < 35 && at < size; shift += 7)
+		{
+			uint8_t byte = data[at++];
+			bits |= uint32_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				value = int32_t(bits >> 1 ^ (0u - (bits & 1)));
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+GhostBounds GhostBoundsFor(const TrackData& track)
+{
+	//Where the cars drive: the gates, waypoints, walls, isles and struts.  The tanks sit off to the sides.
+	float minX = 0.0f;
+	float minZ = 0.0f;
+	float maxX = 0.0f;
+	float maxZ = 0.0f;
+	Extend(track.checkpointX, track.checkpointZ, minX, minZ, maxX, maxZ);
+	Extend(track.waypointX, track.waypointZ, minX, minZ, maxX, maxZ);
+	Extend(track.wallX, track.wallZ, minX, minZ, maxX, maxZ);
+	Extend(track.isleX, track.isleZ, minX, minZ, maxX, maxZ);
+	Extend(track.strutX, track.strutZ, minX, minZ, maxX, maxZ);
+
+	GhostBounds bounds;
+	bounds.minX = minX - courseMargin;
+	bounds.minZ = minZ - courseMargin;
+	bounds.stepX = (maxX - minX + courseMargin * 2) / (gridSteps - 1);
+	bounds.stepZ = (maxZ - minZ + courseMargin * 2) / (gridSteps - 1);
+	return bounds;
+}
+
+void GhostLap::Begin(const GhostBounds& bounds, float sampleInterval)
+{
+	header = {};
+	header.bounds = bounds;
+	header.sampleInterval = sampleInterval;
+	data.clear();
+	data.reserve(lapReserve);
+	std::fill(last, last + 3, 0);
+	std::fill(lastChange, lastChange + 3, 0);
+}
+
+void GhostLap::Add(float x, float z, float yaw)
+{
+	int32_t sample[3];
+	sample[0] = std::min(std::max(int32_t(std::lround((x - header.bounds.minX) / header.bounds.stepX)), 0), gridSteps - 1);
+	sample[1] = std::min(std::max(int32_t(std::lround((z - header.bounds.minZ) / header.bounds.stepZ)), 0), gridSteps - 1);
+	sample[2] = int32_t(std::lround(yaw * ghostYawSteps / 360.0f)) & (ghostYawSteps - 1);
+
+	//The change in the change: next to nothing while the car holds its speed and line.
+	for (int i = 0; i < 3; i++)
+	{
+		int32_t change = i == 2 ? WrapYaw(sample[i] - last[i]) : sample[i] - last[i];
+		int32_t value = change - lastChange[i];
+		uint32_t bits = uint32_t(value) << 1 ^ uint32_t(value >> 31);
+		while (bits >= 0x80)
+		{
+			data.push_back(uint8_t(bits | 0x80));
+			bits >>= 7;
+		}
+		data.push_back(uint8_t(bits));
+		last[i] = sample[i];
+		lastChange[i] = change;
+	}
+	header.sampleCount++;
+	header.byteCount = uint32_t(data.size());
+}
+
+void GhostLap::End(float lapTime)
+{
+	header.lapTime = lapTime;
+	data.shrink_to_fit(); //A library keeps thousands of these.
+}
+
+bool GhostLap::Assign(const GhostLapHeader& lapHeader, const uint8_t* bytes)
+{
+	if (lapHeader.sampleInterval <= 0.0f || lapHeader.bounds.stepX <= 0.0f || lapHeader.bounds.stepZ <= 0.0f)
+	{
+		return false;
+	}
+	header = lapHeader;
+	data.assign(bytes, bytes + lapHeader.byteCount);
+	return true;
+}
+
+size_t GhostLap::RawBytes() const
+{
+	return size_t(std::ceil(header.lapTime * referenceTickRate)) * 3 * sizeof(float);
+}
+
+void GhostPlayer::Start(const GhostLap* ghost)
+{
+	lap = ghost;
+	at = 0;
+	decoded = 0;
+	std::fill(last, last + 3, 0);
+	std::fill(lastChange, lastChange + 3, 0);
+}
+
+void GhostPlayer::DecodeNext()
+{
+	int32_t sample[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int32_t value = 0;
+		if (!ReadSigned(lap->Data(), lap->Bytes(), at, value))
+		{
+			return; //Cut short, so the ghost stops at its last whole sample.
+		}
+		lastChange[i] += value;
+		sample[i] = last[i] + lastChange[i];
+		last[i] = sample[i];
+	}
+
+	//Yaw is kept unwrapped, so it blends the short way between samples.
+	const GhostBounds& bounds = lap->Header().bounds;
+	float* slot = window[decoded & 3];
+	slot[0] = bounds.minX + sample[0] * bounds.stepX;
+	slot[1] = bounds.minZ + sample[1] * bounds.stepZ;
+	slot[2] = sample[2] * 360.0f / ghostYawSteps;
+	decoded++;
+}
+
+CarPose GhostPlayer::Pose(float time)
+{
+	if (lap == nullptr || lap->Samples() == 0)
+	{
+		return { 0.0f, 0.0f, 0.0f };
+	}
+
+	//Between samples k and k + 1, with the samples either side to shape the curve.
+	float position = std::max(time, 0.0f) / lap->Header().sampleInterval;
+	int count = lap->Samples();
+	int k = std::min(int(position), count - 1);
+	float t = k < count - 1 ? position - k : 0.0f;
+	if (std::max(k - 1, 0) < decoded - 4)
+	{
+		Start(lap); //Gone back in time, so decode again from the start.
+	}
+	int need = std::min(k + 3, count);
+	while (decoded < need)
+	{
+		int before = decoded;
+		DecodeNext();
+		if (decoded == before)
+		{
+			count = decoded; //The data ended early.
+			break;
+		}
+	}
+	if (decoded == 0)
+	{
+		return { 0.0f, 0.0f, 0.0f };
+	}
+	k = std::min(k, decoded - 1);
+	const float* p0 = window[std::max(k - 1, 0) & 3];
+	const float* p1 = window[k & 3];
+	const float* p2 = window[std::min(k + 1, decoded - 1) & 3];
+	const float* p3 = window[std::min(k + 2, decoded - 1) & 3];
+
+	//Catmull-Rom for the position, straight blending for the yaw.
+	float t2 = t * t;
+	float t3 = t2 * t;
+	CarPose pose;
+	pose.x = 0.5f * (2 * p1[0] + (p2[0] - p0[0]) * t + (2 * p0[0] - 5 * p1[0] + 4 * p2[0] - p3[0]) * t2 + (3 * p1[0] - p0[0] - 3 * p2[0] + p3[0]) * t3);
+	pose.z = 0.5f * (2 * p1[1] + (p2[1] - p0[1]) * t + (2 * p0[1] - 5 * p1[1] + 4 * p2[1] - p3[1]) * t2 + (3 * p1[1] - p0[1] - 3 * p2[1] + p3[1]) * t3);
+	pose.yaw = p1[2] + (p2[2] - p1[2]) * t;
+	return pose;
+}
+
+GhostRecorder::GhostRecorder(const TrackData& track, float tickTime)
+	: bounds(GhostBoundsFor(track)), tickTime(tickTime)
+{
+	sampleTicks = std::max(int(std::lround(1.0f / (tickTime * ghostSampleRate))), 1);
+	current.Begin(bounds, sampleTicks * tickTime);
+}
+
+void GhostRecorder::Record(const RaceSimulation& sim)
+{
+	const LapTracker& tracker = sim.Laps();
+	if (!sim.GameStarted() || tracker.Gates() == 0 || int(laps.size()) >= tracker.Laps())
+	{
+		return;
+	}
+
+	//A finished lap is kept and the next starts from its finish.
+	int done = int(laps.size());
+	if (tracker.Lap(0) > done)
+	{
+		current.End(tracker.LapTime(0, done));
+		laps.push_back(current);
+		lapStartTick = int(std::lround(tracker.Splits(0)[(done + 1) * tracker.Gates() - 1] / tickTime));
+		nextSample = 0;
+		current.Begin(bounds, sampleTicks * tickTime);
+		if (tracker.Lap(0) >= tracker.Laps())
+		{
+			return;
+		}
+	}
+
+	//Called every tick, so one sample at most is due, and it is taken on its own tick.
+	const CarState& player = sim.Player();
+	int tick = int(std::lround(sim.RaceTime() / tickTime));
+	if (lapStartTick + nextSample * sampleTicks <= tick)
+	{
+		current.Add(player.x, player.z, player.yaw);
+		nextSample++;
+	}
+}
+
+bool GhostLibrary::Load(const std::string& path, uint32_t checksum, std::string& error)
+{
+	trackChecksum = checksum;
+	laps.clear();
+	FILE* probe = fopen(path.c_str(), "rb");
+	if (probe == nullptr)
+	{
+		return true; //Nothing recorded on this track yet.
+	}
+	fclose(probe);
+
+	MappedFile file;
+	if (!file.Open(path, error))
+	{
+		return false;
+	}
+	const uint8_t* data = file.Data();
+	size_t size = file.Size();
+	GhostFileHeader header;
+	if (size < sizeof(header))
+	{
+		error = path + " is too short to be a ghost file";
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, ghostFileMagic, 4) != 0 || header.version != ghostFileVersion || header.byteOrder != trackFileByteOrder)
+	{
+		error = path + " is not a ghost file this build can read";
+		return false;
+	}
+	if (header.trackChecksum != checksum)
+	{
+		error = path + " was recorded on a different track";
+		return false;
+	}
+
+	size_t at = sizeof(header);
+	for (uint32_t i = 0; i < header.lapCount; i++)
+	{
+		GhostLapHeader lapHeader;
+		if (size - at < sizeof(lapHeader))
+		{
+			break;
+		}
+		memcpy(&lapHeader, data + at, sizeof(lapHeader));
+		at += sizeof(lapHeader);
+		GhostLap lap;
+		if (size - at < lapHeader.byteCount || !lap.Assign(lapHeader, data + at))
+		{
+			error = path + " is cut short or damaged";
+			return false;
+		}
+		at += lapHeader.byteCount;
+		laps.push_back(lap);
+	}
+	return true;
+}
+
+bool GhostLibrary::Save(const std::string& path, std::string& error) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+	GhostFileHeader header;
+	memcpy(header.magic, ghostFileMagic, 4);
+	header.version = ghostFileVersion;
+	header.byteOrder = trackFileByteOrder;
+	header.trackChecksum = trackChecksum;
+	header.lapCount = uint32_t(laps.size());
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (const GhostLap& lap : laps)
+	{
+		written = written && fwrite(&lap.Header(), sizeof(GhostLapHeader), 1, file) == 1;
+		written = written && (lap.Bytes() == 0 || fwrite(lap.Data(), lap.Bytes(), 1, file) == 1);
+	}
+	written = fclose(file) == 0 && written;
+	if (!written)
+	{
+		error = "cannot write " + path;
+	}
+	return written;
+}
+
+const GhostLap* GhostLibrary::Best() const
+{
+	const GhostLap* best = nullptr;
+	for (const GhostLap& lap : laps)
+	{
+		best = best == nullptr || lap.LapTime() < best->LapTime() ? &lap : best;
+	}
+	return best;
+}
+
+size_t GhostLibrary::Bytes() const
+{
+	size_t bytes = 0;
+	for (const GhostLap& lap : laps)
+	{
+		bytes += lap.Bytes();
+	}
+	return bytes;
+}
+
+std::string GhostLibraryPath(uint32_t trackChecksum)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "ghosts_%08x.rgho", trackChecksum);
+	return name;
+}
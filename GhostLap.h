@@ -0,0 +1,127 @@
+// Jonathan Walsh
+//Ghost laps: the player's laps recorded to race against later.  A lap is sampled 15 times a
+//second; each sample's position is quantised to a 65536 by 65536 grid over the track's bounds
+//and its yaw to a 4096th of a turn, and stored as the change in its change since the sample
+//before, as a zigzag varint.  A car moves smoothly, so most of those are one byte and a lap takes
+//over ten times less than floats every frame would.  Playback decodes forward a sample at a time
+//and draws a smooth curve through the samples, so dozens of ghosts cost next to nothing.
+#pragma once
+#include "RaceSimulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const char ghostFileMagic[4] = { 'R', 'G', 'H', 'O' };
+const uint32_t ghostFileVersion = 1;
+const float ghostSampleRate = 15.0f; //Samples a second.
+const int ghostYawSteps = 4096; //Per turn.
+
+//The grid positions are quantised to: the track's bounding box with courseMargin round it.
+struct GhostBounds
+{
+	float minX;
+	float minZ;
+	float stepX; //Size of one of the 65536 steps across.
+	float stepZ;
+};
+
+GhostBounds GhostBoundsFor(const TrackData& track);
+
+//Written before each lap's samples.
+struct GhostLapHeader
+{
+	GhostBounds bounds;
+	float sampleInterval; //Seconds between samples.
+	float lapTime;
+	uint32_t sampleCount;
+	uint32_t byteCount; //Encoded samples that follow.
+};
+
+struct GhostFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder; //trackFileByteOrder, as written by this machine.
+	uint32_t trackChecksum; //TrackChecksum of the track the laps were driven on.
+	uint32_t lapCount;
+};
+
+class GhostLap
+{
+public:
+	void Begin(const GhostBounds& bounds, float sampleInterval);
+	void Add(float x, float z, float yaw); //The next sample.
+	void End(float lapTime);
+	bool Assign(const GhostLapHeader& lapHeader, const uint8_t* bytes); //A lap read back from a file.
+
+	const GhostLapHeader& Header() const { return header; }
+	float LapTime() const { return header.lapTime; }
+	int Samples() const { return int(header.sampleCount); }
+	const uint8_t* Data() const { return data.data(); }
+	size_t Bytes() const { return data.size(); }
+	size_t RawBytes() const; //The lap as x, z and yaw floats every 60th of a second.
+
+private:
+	GhostLapHeader header = {};
+	std::vector<uint8_t> data;
+	int32_t last[3] = {}; //The last sample, x, z and yaw.
+	int32_t lastChange[3] = {};
+};
+
+//Draws a ghost.  Pose is given the time since the lap started, and decodes on from where it was
+//last time, so it is cheapest called with times that only go forward.
+class GhostPlayer
+{
+public:
+	void Start(const GhostLap* lap); //Null stops it.
+	bool Playing() const { return lap != nullptr; }
+	CarPose Pose(float time);
+
+private:
+	void DecodeNext();
+
+	const GhostLap* lap = nullptr;
+	size_t at = 0; //Next byte to decode.
+	int decoded = 0; //Samples decoded so far.
+	int32_t last[3] = {};
+	int32_t lastChange[3] = {};
+	float window[4][3]; //The last four samples decoded, by sample number & 3, yaw unwrapped.
+};
+
+//Every lap the player finished, from the start of the race, recorded as the race runs.
+class GhostRecorder
+{
+public:
+	GhostRecorder(const TrackData& track, float tickTime);
+	void Record(const RaceSimulation& sim); //After every tick, so each sample is the car where it was on its own tick.
+	const std::vector<GhostLap>& Laps() const { return laps; }
+
+private:
+	GhostBounds bounds;
+	float tickTime;
+	int sampleTicks; //Ticks between samples.
+	GhostLap current;
+	int nextSample = 0;
+	int lapStartTick = 0;
+	std::vector<GhostLap> laps;
+};
+
+//Reference laps for one track, kept in memory and in one file.
+class GhostLibrary
+{
+public:
+	bool Load(const std::string& path, uint32_t trackChecksum, std::string& error); //A missing file is an empty library.
+	bool Save(const std::string& path, std::string& error) const;
+	void Add(const GhostLap& lap) { laps.push_back(lap); }
+
+	int Count() const { return int(laps.size()); }
+	const GhostLap& Lap(int i) const { return laps[i]; }
+	const GhostLap* Best() const; //Fastest lap, or null if there are none.
+	size_t Bytes() const; //Encoded samples in every lap.
+
+private:
+	uint32_t trackChecksum = 0;
+	std::vector<GhostLap> laps;
+};
+
+std::string GhostLibraryPath(uint32_t trackChecksum); //The file the game keeps a track's laps in.
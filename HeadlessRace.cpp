@@ -0,0 +1,346 @@
+// Jonathan Walsh
+//Runs the race with no window, driven by the autopilot, and prints how it went.
+//With --batch it runs many races with randomly tuned cars across every core instead, and
+//with --replay it reruns a race recorded by the game (or by --record) and checks the result.
+//--ghost adds the autopilot's laps to a ghost library file.  --pipeline runs each frame's ticks
+//on their own thread, with big fields of AI cars split across a pool, as the game does.
+//Builds on Linux without the TL-Engine, see README.md for the file list.
+#include "BatchRunner.h"
+#include "FrameProfiler.h"
+#include "GhostLap.h"
+#include "InputLog.h"
+#include "RaceHud.h"
+#include "ReplayRaceEngine.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
+#include "TrackFile.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <random>
+
+//Every heap allocation in the program goes through here so --alloc-check can count them.
+static std::atomic<long long> allocationCount(0);
+
+void* operator new(std::size_t size)
+{
+	allocationCount++;
+	void* memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	free(memory);
+}
+
+namespace
+{
+	//Races with the thrust, drag, steering and AI speed each moved up to 20% away from the defaults.
+	std::vector<RaceJob> MakeTuningSweep(int count, unsigned seed, float frameTime, int maxFrames)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> tweak(0.8f, 1.2f);
+
+		std::vector<RaceJob> jobs(count);
+		for (int i = 0; i < count; i++)
+		{
+			RaceJob& job = jobs[i];
+			job.name = "race" + std::to_string(i);
+			job.frameTime = frameTime;
+			job.maxFrames = maxFrames;
+			job.settings.defaultThrust *= tweak(random);
+			job.settings.defaultDrag *= tweak(random);
+			job.settings.steeringFactor *= tweak(random);
+			job.settings.nonPlayerCarSpeed *= tweak(random);
+		}
+		return jobs;
+	}
+
+	//Runs the simulation and HUD frame by frame and counts heap allocations after the first frame.
+	int CheckAllocations(const TrackData& track, float frameTime, int maxFrames)
+	{
+		RaceSimulation sim(track);
+		RaceFrame shown;
+		RaceHud hud;
+		long long steadyStart = 0;
+		int frame = 0;
+		for (; frame < maxFrames && !sim.Finished(); frame++)
+		{
+			sim.Advance(AutopilotInput(sim, frame), frameTime);
+			shown.Capture(sim);
+			hud.Update(shown);
+			if (frame == 0)
+			{
+				steadyStart = allocationCount; //The first frame may set things up.
+			}
+		}
+		long long allocations = allocationCount - steadyStart;
+		printf("frames: %d\n", frame);
+		printf("hud text rebuilt: %lld times\n", hud.Reformats());
+		printf("allocations after the first frame: %lld\n", allocations);
+		return allocations == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	float frameTime = 1.0f / 60.0f;
+	int maxFrames = 60 * 60 * 5; //Five minutes of racing.
+	int batch = 0;
+	int threads = 0;
+	unsigned seed = 1;
+	bool verbose = false;
+	bool allocCheck = false;
+	bool pipeline = false;
+	std::string trackPath;
+	std::string profilePath;
+	std::string recordPath;
+	std::string telemetryPath;
+	std::string ghostPath;
+	int aiCars = -1; //Keep the default.
+	float tickRate = 0.0f;
+	std::string replayPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			maxFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc)
+		{
+			frameTime = float(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+		{
+			batch = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			seed = unsigned(strtoul(argv[++i], 0, 10));
+		}
+		else if (strcmp(argv[i], "--track") == 0 && i + 1 < argc)
+		{
+			trackPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			profilePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc)
+		{
+			telemetryPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--ghost") == 0 && i + 1 < argc)
+		{
+			ghostPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+		{
+			replayPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--alloc-check") == 0)
+		{
+			allocCheck = true;
+		}
+		else if (strcmp(argv[i], "--pipeline") == 0)
+		{
+			pipeline = true;
+		}
+		else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+		{
+			tickRate = float(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--ai-cars") == 0 && i + 1 < argc)
+		{
+			aiCars = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--verbose") == 0)
+		{
+			verbose = true;
+		}
+		else
+		{
+			printf("Usage: %s [--track file] [--frames N] [--dt seconds] [--alloc-check] [--profile out.csv|out.json] [--ai-cars N] [--tick-rate hz] [--record log | --replay log] [--telemetry out.rtel] [--ghost library.rgho] [--pipeline [--threads N]] [--batch races [--threads N] [--seed N] [--verbose]]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	//A .htrk track is mapped straight into memory, a text track is parsed.
+	LoadedTrack loadedTrack;
+	std::string error;
+	if (trackPath.empty())
+	{
+		loadedTrack.LoadDefault();
+	}
+	else if (!loadedTrack.Load(trackPath, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	const TrackData& track = loadedTrack.Data();
+
+	if (allocCheck)
+	{
+		return CheckAllocations(track, frameTime, maxFrames);
+	}
+
+	if (batch > 0)
+	{
+		BatchSummary summary;
+		std::vector<RaceJob> jobs = MakeTuningSweep(batch, seed, frameTime, maxFrames);
+		for (RaceJob& job : jobs)
+		{
+			job.settings.tickRate = tickRate > 0.0f ? tickRate : job.settings.tickRate;
+		}
+		std::vector<RaceResult> results = RunBatch(track, jobs, threads, summary);
+		PrintBatchReport(results, summary, verbose);
+		return 0;
+	}
+
+	//A replay runs with the settings it was recorded with, otherwise the autopilot drives.
+	InputLog replay;
+	RaceSettings settings;
+	if (!replayPath.empty())
+	{
+		if (!replay.Load(replayPath, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		if (replay.TrackChecksum() != TrackChecksum(track))
+		{
+			fprintf(stderr, "warning: %s was recorded on a different track\n", replayPath.c_str());
+		}
+		settings = replay.Settings();
+	}
+	else
+	{
+		settings.aiCarCount = aiCars >= 0 ? aiCars : settings.aiCarCount;
+		settings.tickRate = tickRate > 0.0f ? tickRate : settings.tickRate;
+	}
+	RaceSimulation sim(track, settings);
+	std::unique_ptr<ThreadPool> workers;
+	if (pipeline)
+	{
+		workers = std::make_unique<ThreadPool>(threads);
+		sim.SetWorkers(workers.get());
+	}
+	NullRaceEngine autopilot([&sim](int frame) { return AutopilotInput(sim, frame); }, frameTime, maxFrames);
+	ReplayRaceEngine replayer(replay);
+	IRaceEngine& engine = replayPath.empty() ? static_cast<IRaceEngine&>(autopilot) : replayer;
+
+	InputRecorder recorder;
+	if (!recordPath.empty() && !recorder.Open(recordPath, track, settings, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	//Headless races have no frame rate to keep up, so they wait for the writer rather than drop records.
+	TelemetryWriter telemetry;
+	telemetry.WaitWhenFull(true);
+	if (!telemetryPath.empty() && !telemetry.Open(telemetryPath, sim, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	GhostLibrary ghosts;
+	if (!ghostPath.empty() && !ghosts.Load(ghostPath, TrackChecksum(track), error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	GhostRecorder ghostRecorder(track, sim.TickTime());
+
+#if RACE_PROFILE
+	static FrameProfiler profiler; //Too big for the stack.
+	if (!profilePath.empty())
+	{
+		FrameProfiler::Install(&profiler);
+	}
+#endif
+
+	auto start = std::chrono::steady_clock::now();
+	RunRace(engine, sim, recorder.IsOpen() ? &recorder : nullptr, telemetry.IsOpen() ? &telemetry : nullptr, ghostPath.empty() ? nullptr : &ghostRecorder, pipeline);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (!profilePath.empty())
+	{
+#if RACE_PROFILE
+		FrameProfiler::Install(nullptr);
+		bool json = profilePath.size() >= 5 && profilePath.compare(profilePath.size() - 5, 5, ".json") == 0;
+		if (!(json ? profiler.ExportJson(profilePath) : profiler.ExportCsv(profilePath)))
+		{
+			fprintf(stderr, "Could not write %s\n", profilePath.c_str());
+			return 1;
+		}
+#else
+		fprintf(stderr, "This build has the profiler compiled out (RACE_PROFILE is 0)\n");
+#endif
+	}
+
+	const CarState& player = sim.Player();
+	printf("frames: %d\n", sim.FrameCount());
+	printf("finished: %s\n", sim.Finished() ? "yes" : "no");
+	printf("checkpoints: %d\n", sim.Laps().GatesPassed(0));
+	printf("race time: %.3f s\n", sim.RaceTime());
+	printf("health: %d\n", player.health);
+	printf("frames per second: %.0f\n", seconds > 0.0 ? sim.FrameCount() / seconds : 0.0);
+
+	if (!ghostPath.empty())
+	{
+		size_t bytes = 0;
+		size_t rawBytes = 0;
+		for (const GhostLap& lap : ghostRecorder.Laps())
+		{
+			ghosts.Add(lap);
+			bytes += lap.Bytes();
+			rawBytes += lap.RawBytes();
+		}
+		if (!ghosts.Save(ghostPath, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		printf("ghost laps: %d recorded, %d in the library (%zu bytes)\n", int(ghostRecorder.Laps().size()), ghosts.Count(), ghosts.Bytes());
+		printf("ghost size: %zu bytes, %.1fx smaller than floats every frame\n", bytes, bytes > 0 ? double(rawBytes) / bytes : 0.0);
+	}
+
+	if (!replayPath.empty())
+	{
+		//The replay must end exactly where the recording did, to the bit.
+		if (!replay.HasFooter())
+		{
+			printf("matches recording: unknown, the log has no ending (the game did not close cleanly)\n");
+			return 0;
+		}
+		bool matches = replay.Matches(sim);
+		printf("matches recording: %s\n", matches ? "yes" : "no");
+		return matches ? 0 : 1;
+	}
+	return 0;
+}
@@ -0,0 +1,196 @@
+// Jonathan Walsh
+#include "InputLog.h"
+#include "TrackFile.h"
+#include <cstring>
+
+namespace
+{
+	const int recordBlock = 1024; //Records buffered before each write.
+
+	uint32_t HashBytes(uint32_t hash, const void* bytes, size_t count)
+	{
+		const unsigned char* data = static_cast<const unsigned char*>(bytes);
+		for (size_t i = 0; i < count; i++)
+		{
+			hash = (hash ^ data[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	uint32_t HashArray(uint32_t hash, const TrackArray& values)
+	{
+		hash = HashBytes(hash, &values.count, sizeof(values.count));
+		return HashBytes(hash, values.data, sizeof(float) * size_t(values.count));
+	}
+
+	InputLogFooter MakeFooter(const RaceSimulation& sim, uint32_t frames)
+	{
+		InputLogFooter footer;
+		memcpy(footer.magic, inputLogEndMagic, sizeof(footer.magic));
+		footer.frames = frames;
+		footer.playerX = sim.Player().x;
+		footer.playerZ = sim.Player().z;
+		footer.raceTime = sim.RaceTime();
+		footer.health = sim.Player().health;
+		footer.collisions = sim.Player().collisions;
+		footer.gatesPassed = sim.Laps().GatesPassed(0);
+		return footer;
+	}
+}
+
+uint32_t TrackChecksum(const TrackData& track)
+{
+	const TrackArray* arrays[] = {
+		&track.checkpointX, &track.checkpointZ, &track.checkpointRotation, &track.strutX, &track.strutZ,
+		&track.isleX, &track.isleZ, &track.wallX, &track.wallZ,
+		&track.tankX, &track.tankY, &track.tankZ, &track.tankRotation, &track.waypointX, &track.waypointZ
+	};
+	uint32_t hash = 2166136261u;
+	for (const TrackArray* values : arrays)
+	{
+		hash = HashArray(hash, *values);
+	}
+	return hash;
+}
+
+InputRecorder::~InputRecorder()
+{
+	if (file != nullptr)
+	{
+		Flush();
+		fclose(file);
+	}
+}
+
+bool InputRecorder::Open(const std::string& path, const TrackData& track, const RaceSettings& settings, std::string& error)
+{
+	file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+	InputLogHeader header;
+	memcpy(header.magic, inputLogMagic, sizeof(header.magic));
+	header.version = inputLogVersion;
+	header.byteOrder = trackFileByteOrder;
+	header.settingsSize = sizeof(RaceSettings);
+	header.trackChecksum = TrackChecksum(track);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(&settings, sizeof(settings), 1, file);
+
+	pending.reserve(recordBlock);
+	frames = 0;
+	return true;
+}
+
+void InputRecorder::Record(float frameTime, const RaceInput& input)
+{
+	if (file == nullptr)
+	{
+		return;
+	}
+	pending.push_back({ frameTime, input });
+	frames++;
+	if (int(pending.size()) >= recordBlock)
+	{
+		Flush();
+	}
+}
+
+void InputRecorder::Flush()
+{
+	fwrite(pending.data(), sizeof(InputRecord), pending.size(), file);
+	fflush(file); //Keep what has been played so far if the game crashes.
+	pending.clear();
+}
+
+void InputRecorder::Close(const RaceSimulation& sim)
+{
+	if (file == nullptr)
+	{
+		return;
+	}
+	Flush();
+	InputLogFooter footer = MakeFooter(sim, frames);
+	fwrite(&footer, sizeof(footer), 1, file);
+	fclose(file);
+	file = nullptr;
+}
+
+bool InputLog::Load(const std::string& path, std::string& error)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+	std::vector<unsigned char> bytes;
+	unsigned char block[4096];
+	size_t got;
+	while ((got = fread(block, 1, sizeof(block), file)) > 0)
+	{
+		bytes.insert(bytes.end(), block, block + got);
+	}
+	fclose(file);
+
+	InputLogHeader header;
+	if (bytes.size() < sizeof(header))
+	{
+		error = path + ": too small to be an input log";
+		return false;
+	}
+	memcpy(&header, bytes.data(), sizeof(header));
+	if (memcmp(header.magic, inputLogMagic, sizeof(header.magic)) != 0 || header.byteOrder != trackFileByteOrder)
+	{
+		error = path + ": not an input log";
+		return false;
+	}
+	if (header.version != inputLogVersion || header.settingsSize != sizeof(RaceSettings))
+	{
+		error = path + ": recorded by a different version of the game";
+		return false;
+	}
+	size_t recordStart = sizeof(header) + sizeof(RaceSettings);
+	if (bytes.size() < recordStart)
+	{
+		error = path + ": settings are cut short";
+		return false;
+	}
+	memcpy(&settings, bytes.data() + sizeof(header), sizeof(RaceSettings));
+	trackChecksum = header.trackChecksum;
+
+	//The footer is only there if the race was closed cleanly.
+	size_t recordEnd = bytes.size();
+	hasFooter = false;
+	if (recordEnd - recordStart >= sizeof(footer))
+	{
+		memcpy(&footer, bytes.data() + recordEnd - sizeof(footer), sizeof(footer));
+		if (memcmp(footer.magic, inputLogEndMagic, sizeof(footer.magic)) == 0)
+		{
+			hasFooter = true;
+			recordEnd -= sizeof(footer);
+		}
+	}
+
+	size_t count = (recordEnd - recordStart) / sizeof(InputRecord); //A torn last record is dropped.
+	if (hasFooter && count != footer.frames)
+	{
+		error = path + ": frame count does not match the footer";
+		return false;
+	}
+	records.resize(count);
+	memcpy(records.data(), bytes.data() + recordStart, count * sizeof(InputRecord));
+	return true;
+}
+
+bool InputLog::Matches(const RaceSimulation& sim) const
+{
+	if (!hasFooter)
+	{
+		return false;
+	}
+	InputLogFooter replayed = MakeFooter(sim, footer.frames);
+	return memcmp(&replayed, &footer, sizeof(footer)) == 0;
+}
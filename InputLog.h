@@ -0,0 +1,91 @@
+// Jonathan Walsh
+//Input logs.  A race is reproduced exactly by its settings and, for every frame, the frame time
+//and the RaceInput read that frame.  The log is a small header, the settings, one 12 byte record
+//per frame and, if the race ended cleanly, a footer with how it ended so a replay can check it
+//got the same result.  A log cut short by a crash still replays up to its last whole frame.
+#pragma once
+#include "RaceSimulation.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+const char inputLogMagic[4] = { 'R', 'R', 'E', 'P' };
+const char inputLogEndMagic[4] = { 'R', 'E', 'N', 'D' };
+const uint32_t inputLogVersion = 4;
+
+struct InputLogHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder; //trackFileByteOrder, as written by this machine.
+	uint32_t settingsSize; //sizeof(RaceSettings), which follows the header.
+	uint32_t trackChecksum; //TrackChecksum of the track the race was run on.
+};
+
+struct InputRecord
+{
+	float frameTime;
+	RaceInput input;
+	uint16_t padding = 0; //Written out, so it is never left uninitialised.
+};
+
+//How the recorded race ended.
+struct InputLogFooter
+{
+	char magic[4];
+	uint32_t frames;
+	float playerX;
+	float playerZ;
+	float raceTime;
+	int32_t health;
+	int32_t collisions;
+	int32_t gatesPassed; //Checkpoints the player passed, over every lap.
+};
+
+uint32_t TrackChecksum(const TrackData& track); //FNV-1a over the track layout.
+
+//Writes a log as the race runs.  Records are buffered and written in blocks, so Record never allocates.
+class InputRecorder
+{
+public:
+	InputRecorder() {}
+	~InputRecorder();
+
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	bool Open(const std::string& path, const TrackData& track, const RaceSettings& settings, std::string& error);
+	void Record(float frameTime, const RaceInput& input);
+	void Close(const RaceSimulation& sim); //Writes the footer.
+	bool IsOpen() const { return file != nullptr; }
+
+private:
+	void Flush();
+
+	FILE* file = nullptr;
+	std::vector<InputRecord> pending;
+	uint32_t frames = 0;
+};
+
+class InputLog
+{
+public:
+	bool Load(const std::string& path, std::string& error);
+
+	const RaceSettings& Settings() const { return settings; }
+	uint32_t TrackChecksum() const { return trackChecksum; }
+	const std::vector<InputRecord>& Records() const { return records; }
+	bool HasFooter() const { return hasFooter; }
+	const InputLogFooter& Footer() const { return footer; }
+
+	//True when the simulation ended the way the recorded race did.
+	bool Matches(const RaceSimulation& sim) const;
+
+private:
+	RaceSettings settings;
+	uint32_t trackChecksum = 0;
+	std::vector<InputRecord> records;
+	bool hasFooter = false;
+	InputLogFooter footer = {};
+};
@@ -0,0 +1,66 @@
+// Jonathan Walsh
+#include "LapTracker.h"
+#include <cmath>
+
+void CheckpointGates::Build(const TrackArray& checkpointX, const TrackArray& checkpointZ, const TrackArray& checkpointRotation, float width)
+{
+	const float degreesToRadians = 3.14159265f / 180.0f;
+	int count = checkpointX.Count();
+	x.assign(checkpointX.data, checkpointX.data + count);
+	z.assign(checkpointZ.data, checkpointZ.data + count);
+	alongX.resize(count);
+	alongZ.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		//Local X of a model turned around Y, row 0 of its TL-Engine matrix.
+		float rotation = checkpointRotation[i] * degreesToRadians;
+		alongX[i] = std::cos(rotation);
+		alongZ[i] = -std::sin(rotation);
+	}
+	halfWidth = width / 2;
+}
+
+bool CheckpointGates::Crossed(int gate, float oldX, float oldZ, float newX, float newZ) const
+{
+	//Which side of the gate line each end of the move is on, measured along the gate's local Z.
+	float acrossX = -alongZ[gate];
+	float acrossZ = alongX[gate];
+	float before = (oldX - x[gate]) * acrossX + (oldZ - z[gate]) * acrossZ;
+	float after = (newX - x[gate]) * acrossX + (newZ - z[gate]) * acrossZ;
+	if ((before < 0.0f) == (after < 0.0f))
+	{
+		return false;
+	}
+
+	//Where the move crosses the line has to be between the struts.
+	float t = before / (before - after);
+	float crossX = oldX + (newX - oldX) * t - x[gate];
+	float crossZ = oldZ + (newZ - oldZ) * t - z[gate];
+	return std::fabs(crossX * alongX[gate] + crossZ * alongZ[gate]) <= halfWidth;
+}
+
+void LapTracker::Reset(int carCount, int gates, int laps)
+{
+	gateCount = gates;
+	lapCount = laps > 0 ? laps : 1;
+	passed.assign(carCount, 0);
+	splits.assign(size_t(carCount) * gateCount * lapCount, 0.0f);
+}
+
+bool LapTracker::Update(const CheckpointGates& gates, int car, float oldX, float oldZ, float newX, float newZ, float raceTime)
+{
+	if (gateCount == 0 || Finished(car) || !gates.Crossed(NextGate(car), oldX, oldZ, newX, newZ))
+	{
+		return false;
+	}
+	splits[size_t(car) * gateCount * lapCount + passed[car]] = raceTime;
+	passed[car]++;
+	return true;
+}
+
+float LapTracker::LapTime(int car, int lap) const
+{
+	const float* carSplits = Splits(car);
+	float end = carSplits[(lap + 1) * gateCount - 1];
+	return lap > 0 ? end - carSplits[lap * gateCount - 1] : end;
+}
@@ -0,0 +1,54 @@
+// Jonathan Walsh
+//Checkpoint gates and lap timing for any number of checkpoints, laps and cars.  Each car only
+//ever tests the one gate it has to pass next, so the cost per car per frame is the same however
+//many gates the track has.
+#pragma once
+#include "TrackData.h"
+#include <vector>
+
+//Each checkpoint as a line across the track: its centre, the direction along it (the model's
+//local X after its rotation) and half its width.  A car passes it by crossing that line.
+struct CheckpointGates
+{
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<float> alongX;
+	std::vector<float> alongZ;
+	float halfWidth = 0.0f;
+
+	void Build(const TrackArray& checkpointX, const TrackArray& checkpointZ, const TrackArray& checkpointRotation, float width);
+	int Count() const { return int(x.size()); }
+
+	//True when the move from (oldX, oldZ) to (newX, newZ) crosses the gate, either way through.
+	bool Crossed(int gate, float oldX, float oldZ, float newX, float newZ) const;
+};
+
+class LapTracker
+{
+public:
+	void Reset(int carCount, int gateCount, int lapCount);
+
+	//Tests the car's move for this frame against its next gate.  Returns true if it passed it,
+	//in which case raceTime is recorded as the car's split for that gate.
+	bool Update(const CheckpointGates& gates, int car, float oldX, float oldZ, float newX, float newZ, float raceTime);
+
+	int Cars() const { return int(passed.size()); }
+	int Gates() const { return gateCount; }
+	int Laps() const { return lapCount; }
+
+	//A track with no checkpoints has no laps to finish: the car stays on gate 0 of lap 0.
+	int GatesPassed(int car) const { return passed[car]; } //Counted over every lap.
+	int NextGate(int car) const { return gateCount > 0 ? passed[car] % gateCount : 0; }
+	int Lap(int car) const { return gateCount > 0 ? passed[car] / gateCount : 0; } //Laps completed.
+	bool Finished(int car) const { return gateCount > 0 && passed[car] >= gateCount * lapCount; }
+
+	//Race time as the car passed each gate, GatesPassed(car) of them.
+	const float* Splits(int car) const { return splits.data() + size_t(car) * gateCount * lapCount; }
+	float LapTime(int car, int lap) const; //Time for a completed lap.
+
+private:
+	int gateCount = 0;
+	int lapCount = 1;
+	std::vector<int> passed;
+	std::vector<float> splits; //gateCount * lapCount per car, so recording one never allocates.
+};
@@ -0,0 +1,100 @@
+// Jonathan Walsh
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path, std::string& error)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		error = "cannot map " + path;
+		return false;
+	}
+	fileHandle = file;
+	mappingHandle = mapping;
+	base = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	size = size_t(fileSize.QuadPart);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+	struct stat info;
+	void* mapping = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	close(file); //The mapping keeps the file open.
+	if (mapping != MAP_FAILED)
+	{
+		base = static_cast<const unsigned char*>(mapping);
+		size = size_t(info.st_size);
+	}
+#endif
+	if (base == nullptr)
+	{
+		Close();
+		error = "cannot map " + path;
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (base != nullptr)
+	{
+		UnmapViewOfFile(base);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr)
+	{
+		CloseHandle(fileHandle);
+	}
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	if (base != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(base), size);
+	}
+#endif
+	base = nullptr;
+	size = 0;
+}
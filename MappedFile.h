@@ -0,0 +1,28 @@
+// Jonathan Walsh
+//A whole file mapped read-only into memory, for the binary track and mesh files.
+#pragma once
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path, std::string& error);
+	void Close();
+	const unsigned char* Data() const { return base; }
+	size_t Size() const { return size; }
+
+private:
+	const unsigned char* base = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
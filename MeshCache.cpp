@@ -0,0 +1,457 @@
+// Jonathan Walsh
+#include "MeshCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	const uint64_t meshAlignment = 16;
+
+	static_assert(sizeof(MeshVertex) == 32, "Mesh vertex layout changed");
+	static_assert(sizeof(MeshFileHeader) == 64, "Mesh file header layout changed");
+
+	uint64_t IndexOffset(uint32_t vertexCount)
+	{
+		uint64_t end = sizeof(MeshFileHeader) + uint64_t(vertexCount) * sizeof(MeshVertex);
+		return (end + meshAlignment - 1) / meshAlignment * meshAlignment;
+	}
+
+	//Splits a text .x file into words, numbers and braces.  Separators, strings, GUIDs and comments are dropped.
+	class XTokens
+	{
+	public:
+		XTokens(const std::string& text, size_t start) : text(text), at(start) {}
+
+		bool Next(std::string& token)
+		{
+			while (at < text.size())
+			{
+				char c = text[at];
+				if (c == '#' || (c == '/' && at + 1 < text.size() && text[at + 1] == '/'))
+				{
+					while (at < text.size() && text[at] != '\n')
+					{
+						at++;
+					}
+				}
+				else if (c == '"' || c == '<')
+				{
+					char end = c == '"' ? '"' : '>';
+					size_t close = text.find(end, at + 1);
+					at = close == std::string::npos ? text.size() : close + 1;
+				}
+				else if (c == '{' || c == '}')
+				{
+					token.assign(1, c);
+					at++;
+					return true;
+				}
+				else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.' || c == '+')
+				{
+					size_t start = at;
+					while (at < text.size() && (std::isalnum(static_cast<unsigned char>(text[at])) || strchr("_-.+", text[at]) != nullptr))
+					{
+						at++;
+					}
+					token.assign(text, start, at - start);
+					return true;
+				}
+				else
+				{
+					at++; //Separators and anything else.
+				}
+			}
+			return false;
+		}
+
+		bool Number(float& value)
+		{
+			std::string token;
+			if (!Next(token))
+			{
+				return false;
+			}
+			char* end = nullptr;
+			value = strtof(token.c_str(), &end);
+			return end != token.c_str() && *end == '\0';
+		}
+
+		bool Count(int& value)
+		{
+			float number;
+			if (!Number(number) || number < 0.0f || number != float(int(number)))
+			{
+				return false;
+			}
+			value = int(number);
+			return true;
+		}
+
+		//Skips to the brace that closes the block just opened.
+		bool SkipBlock()
+		{
+			int depth = 1;
+			std::string token;
+			while (depth > 0 && Next(token))
+			{
+				depth += token == "{" ? 1 : (token == "}" ? -1 : 0);
+			}
+			return depth == 0;
+		}
+
+	private:
+		const std::string& text;
+		size_t at;
+	};
+
+	//Reads one Mesh block, from just after its opening brace, and appends it to the mesh.
+	bool ReadMesh(XTokens& tokens, MeshData& mesh, std::string& error)
+	{
+		uint32_t first = uint32_t(mesh.vertices.size());
+		int vertexCount;
+		if (!tokens.Count(vertexCount))
+		{
+			error = "bad vertex count";
+			return false;
+		}
+		for (int i = 0; i < vertexCount; i++)
+		{
+			MeshVertex vertex = {};
+			if (!tokens.Number(vertex.x) || !tokens.Number(vertex.y) || !tokens.Number(vertex.z))
+			{
+				error = "bad vertex";
+				return false;
+			}
+			mesh.vertices.push_back(vertex);
+		}
+
+		int faceCount;
+		if (!tokens.Count(faceCount))
+		{
+			error = "bad face count";
+			return false;
+		}
+		for (int f = 0; f < faceCount; f++)
+		{
+			int corners;
+			if (!tokens.Count(corners) || corners < 3)
+			{
+				error = "bad face";
+				return false;
+			}
+			int firstCorner = 0, lastCorner = 0;
+			for (int c = 0; c < corners; c++)
+			{
+				int index;
+				if (!tokens.Count(index) || index >= vertexCount)
+				{
+					error = "face index out of range";
+					return false;
+				}
+				if (c == 0)
+				{
+					firstCorner = index;
+				}
+				else if (c >= 2)
+				{
+					//A fan from the first corner.
+					mesh.indices.push_back(first + firstCorner);
+					mesh.indices.push_back(first + lastCorner);
+					mesh.indices.push_back(first + index);
+				}
+				lastCorner = index;
+			}
+		}
+
+		//Normals and texture coordinates, when there is one per vertex.  Other blocks are skipped.
+		std::string token;
+		while (tokens.Next(token) && token != "}")
+		{
+			if (token == "{")
+			{
+				if (!tokens.SkipBlock())
+				{
+					break;
+				}
+				continue;
+			}
+			bool normals = token == "MeshNormals";
+			bool textureCoords = token == "MeshTextureCoords";
+			while (tokens.Next(token) && token != "{")
+			{
+				//Block name.
+			}
+			if (!normals && !textureCoords)
+			{
+				tokens.SkipBlock();
+				continue;
+			}
+			int count;
+			if (!tokens.Count(count))
+			{
+				error = "bad normal or texture coordinate count";
+				return false;
+			}
+			int components = normals ? 3 : 2;
+			for (int i = 0; i < count; i++)
+			{
+				float value[3] = {};
+				for (int c = 0; c < components; c++)
+				{
+					if (!tokens.Number(value[c]))
+					{
+						error = "bad normal or texture coordinate";
+						return false;
+					}
+				}
+				if (count == vertexCount)
+				{
+					MeshVertex& vertex = mesh.vertices[first + i];
+					if (normals)
+					{
+						vertex.normalX = value[0];
+						vertex.normalY = value[1];
+						vertex.normalZ = value[2];
+					}
+					else
+					{
+						vertex.u = value[0];
+						vertex.v = value[1];
+					}
+				}
+			}
+			tokens.SkipBlock(); //The normals' face list.
+		}
+		return true;
+	}
+
+	bool SourceStamp(const std::string& path, uint64_t& size, int64_t& time, std::string& error)
+	{
+		std::error_code failed;
+		size = uint64_t(std::filesystem::file_size(path, failed));
+		if (!failed)
+		{
+			time = int64_t(std::filesystem::last_write_time(path, failed).time_since_epoch().count());
+		}
+		if (failed)
+		{
+			error = "cannot open " + path;
+			return false;
+		}
+		return true;
+	}
+}
+
+bool ParseXMesh(const std::string& text, MeshData& mesh, std::string& error)
+{
+	mesh = MeshData();
+	if (text.size() < 16 || text.compare(0, 4, "xof ") != 0 || text.compare(8, 3, "txt") != 0)
+	{
+		error = "not a text .x file";
+		return false;
+	}
+
+	//Mesh blocks can sit at the top level or inside frames.  Templates and everything else are stepped over.
+	XTokens tokens(text, 16); //After the header.
+	std::string token;
+	while (tokens.Next(token))
+	{
+		if (token == "template")
+		{
+			//The template's name (often Mesh itself) and its whole body.
+			while (tokens.Next(token) && token != "{")
+			{
+			}
+			tokens.SkipBlock();
+		}
+		else if (token == "Mesh")
+		{
+			while (tokens.Next(token) && token != "{")
+			{
+				//Mesh name.
+			}
+			if (!ReadMesh(tokens, mesh, error))
+			{
+				return false;
+			}
+		}
+	}
+	if (mesh.vertices.empty())
+	{
+		error = "no mesh found";
+		return false;
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.boundsMin[axis] = mesh.boundsMax[axis] = (&mesh.vertices[0].x)[axis];
+	}
+	for (const MeshVertex& vertex : mesh.vertices)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			mesh.boundsMin[axis] = std::min(mesh.boundsMin[axis], (&vertex.x)[axis]);
+			mesh.boundsMax[axis] = std::max(mesh.boundsMax[axis], (&vertex.x)[axis]);
+		}
+	}
+	return true;
+}
+
+bool WriteMeshFile(const std::string& path, const MeshData& mesh, uint64_t sourceSize, int64_t sourceTime, std::string& error)
+{
+	MeshFileHeader header = {};
+	memcpy(header.magic, meshFileMagic, sizeof(header.magic));
+	header.version = meshFileVersion;
+	header.byteOrder = meshFileByteOrder;
+	header.vertexCount = uint32_t(mesh.vertices.size());
+	header.indexCount = uint32_t(mesh.indices.size());
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	memcpy(header.boundsMin, mesh.boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, mesh.boundsMax, sizeof(header.boundsMax));
+
+	//Written under another name and moved into place, so a reader never maps half a file.
+	std::string partial = path + ".part";
+	FILE* file = fopen(partial.c_str(), "wb");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+	const char padding[meshAlignment] = {};
+	uint64_t vertexEnd = sizeof(header) + mesh.vertices.size() * sizeof(MeshVertex);
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(mesh.vertices.data(), sizeof(MeshVertex), mesh.vertices.size(), file);
+	fwrite(padding, 1, size_t(IndexOffset(header.vertexCount) - vertexEnd), file);
+	fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file);
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+
+	std::error_code failed;
+	if (ok)
+	{
+		std::filesystem::rename(partial, path, failed);
+	}
+	if (!ok || failed)
+	{
+		std::filesystem::remove(partial, failed);
+		error = "cannot write " + path;
+		return false;
+	}
+	return true;
+}
+
+bool CachedMesh::Open(const std::string& sourcePath, const std::string& cachePath, std::string& error)
+{
+	file.Close();
+	view = MeshView();
+	rebuilt = false;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	if (!SourceStamp(sourcePath, sourceSize, sourceTime, error))
+	{
+		return false;
+	}
+
+	//Use the cache as it is if it was built from this exact source.
+	std::string ignored;
+	if (file.Open(cachePath, ignored) && Bind(sourceSize, sourceTime, ignored))
+	{
+		return true;
+	}
+	file.Close();
+
+	std::ifstream source(sourcePath.c_str(), std::ios::binary);
+	std::ostringstream text;
+	text << source.rdbuf();
+	MeshData mesh;
+	if (!source || !ParseXMesh(text.str(), mesh, error))
+	{
+		error = sourcePath + ": " + (error.empty() ? "cannot read" : error);
+		return false;
+	}
+	if (!WriteMeshFile(cachePath, mesh, sourceSize, sourceTime, error) || !file.Open(cachePath, error) || !Bind(sourceSize, sourceTime, error))
+	{
+		file.Close();
+		return false;
+	}
+	rebuilt = true;
+	return true;
+}
+
+bool CachedMesh::Bind(uint64_t sourceSize, int64_t sourceTime, std::string& error)
+{
+	const unsigned char* base = file.Data();
+	size_t size = file.Size();
+	if (size < sizeof(MeshFileHeader))
+	{
+		error = "too small to be a mesh file";
+		return false;
+	}
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(base);
+	if (memcmp(header->magic, meshFileMagic, sizeof(header->magic)) != 0 || header->version != meshFileVersion || header->byteOrder != meshFileByteOrder)
+	{
+		error = "not a current mesh file";
+		return false;
+	}
+	if (header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+	{
+		error = "mesh file is out of date";
+		return false;
+	}
+	uint64_t indexOffset = IndexOffset(header->vertexCount);
+	if (header->indexCount % 3 != 0 || indexOffset > size || uint64_t(header->indexCount) * sizeof(uint32_t) > size - indexOffset)
+	{
+		error = "mesh file is cut short";
+		return false;
+	}
+
+	view.vertices = reinterpret_cast<const MeshVertex*>(base + sizeof(MeshFileHeader));
+	view.indices = reinterpret_cast<const uint32_t*>(base + indexOffset);
+	view.vertexCount = int(header->vertexCount);
+	view.indexCount = int(header->indexCount);
+	memcpy(view.boundsMin, header->boundsMin, sizeof(view.boundsMin));
+	memcpy(view.boundsMax, header->boundsMax, sizeof(view.boundsMax));
+	for (int i = 0; i < view.indexCount; i++)
+	{
+		if (view.indices[i] >= header->vertexCount)
+		{
+			view = MeshView();
+			error = "mesh index out of range";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MeshCache::Load(const std::vector<std::string>& names, const std::string& sourceFolder, const std::string& cacheFolder, ThreadPool& pool)
+{
+	std::error_code failed;
+	std::filesystem::create_directories(cacheFolder, failed);
+
+	meshes.clear();
+	errors.assign(names.size(), std::string());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		meshes.emplace_back(new CachedMesh());
+	}
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		std::string source = (std::filesystem::path(sourceFolder) / names[i]).string();
+		std::string cache = (std::filesystem::path(cacheFolder) / std::filesystem::path(names[i]).replace_extension(".hmsh")).string();
+		CachedMesh* mesh = meshes[i].get();
+		std::string* error = &errors[i];
+		pool.Submit([mesh, source, cache, error]()
+		{
+			mesh->Open(source, cache, *error);
+		});
+	}
+	pool.WaitIdle();
+	return std::all_of(errors.begin(), errors.end(), [](const std::string& error) { return error.empty(); });
+}
@@ -0,0 +1,94 @@
+// Jonathan Walsh
+//Binary mesh cache.  Text DirectX .x meshes are parsed once into .hmsh files holding a vertex
+//buffer, an index buffer and the bounds, at aligned offsets so they are mapped and used where
+//they lie.  Each cache file records the size and write time of the .x it came from and is only
+//rebuilt when those change.  A MeshCache loads a whole list of meshes in parallel.
+#pragma once
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const char meshFileMagic[4] = { 'H', 'M', 'S', 'H' };
+const uint32_t meshFileVersion = 1;
+const uint32_t meshFileByteOrder = 0x01020304;
+
+struct MeshVertex
+{
+	float x, y, z;
+	float normalX, normalY, normalZ;
+	float u, v;
+};
+
+struct MeshFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t vertexCount; //Vertices follow the header.
+	uint32_t indexCount; //Triangle indices follow the vertices, on a 16 byte boundary.
+	uint32_t padding;
+	uint64_t sourceSize; //The .x file this was built from.
+	int64_t sourceTime;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+//A mesh being built in memory.
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices; //Three per triangle.
+	float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+//Read-only mesh, pointing into a mapped cache file.
+struct MeshView
+{
+	const MeshVertex* vertices;
+	const uint32_t* indices;
+	int vertexCount;
+	int indexCount;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+//Reads every Mesh block in a text .x file, with its normals and texture coordinates when they are
+//given per vertex.  Polygons are split into triangles.  Frame transforms are not applied.
+bool ParseXMesh(const std::string& text, MeshData& mesh, std::string& error);
+bool WriteMeshFile(const std::string& path, const MeshData& mesh, uint64_t sourceSize, int64_t sourceTime, std::string& error);
+
+//One mesh, mapped from its cache file, which is rebuilt from the .x first when it is missing or stale.
+class CachedMesh
+{
+public:
+	bool Open(const std::string& sourcePath, const std::string& cachePath, std::string& error);
+	const MeshView& View() const { return view; }
+	bool Rebuilt() const { return rebuilt; } //True when the .x had to be parsed.
+
+private:
+	bool Bind(uint64_t sourceSize, int64_t sourceTime, std::string& error);
+
+	MappedFile file;
+	MeshView view = {};
+	bool rebuilt = false;
+};
+
+class MeshCache
+{
+public:
+	//Opens sourceFolder/name for every name at once, caching in cacheFolder.  False if any failed, see Error.
+	bool Load(const std::vector<std::string>& names, const std::string& sourceFolder, const std::string& cacheFolder, ThreadPool& pool);
+
+	int Count() const { return int(meshes.size()); }
+	const MeshView& Mesh(int i) const { return meshes[i]->View(); }
+	bool Rebuilt(int i) const { return meshes[i]->Rebuilt(); }
+	const std::string& Error(int i) const { return errors[i]; } //Empty when the mesh loaded.
+
+private:
+	std::vector<std::unique_ptr<CachedMesh>> meshes;
+	std::vector<std::string> errors;
+};
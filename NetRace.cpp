@@ -0,0 +1,322 @@
+// Jonathan Walsh
+//Runs a networked race with no window.  --server owns the race and ticks it in real time,
+//--client joins one and drives its car by autopilot from the snapshots alone, and --bench runs
+//a server and its clients over loopback in one process and reports the bytes and CPU time per
+//tick as the number of cars grows.
+//Builds on Linux without the TL-Engine, see README.md for the file list.
+#include "InputLog.h"
+#include "NullRaceEngine.h"
+#include "RaceNet.h"
+#include "TrackFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const float joinRetry = 0.25f; //Seconds between join requests.
+	const float joinTimeout = 5.0f;
+	const float serverSilence = 5.0f; //A client gives up when it hears nothing for this long.
+
+	//Sends joins until the server answers.
+	bool Connect(RaceClient& client, const NetAddress& server, uint32_t trackChecksum, std::string& error)
+	{
+		auto start = Clock::now();
+		float nextJoin = 0.0f;
+		while (!client.Connected() && !client.Refused())
+		{
+			float waited = std::chrono::duration<float>(Clock::now() - start).count();
+			if (waited > joinTimeout)
+			{
+				error = "no answer from the server";
+				return false;
+			}
+			if (waited >= nextJoin)
+			{
+				if (!client.Join(server, trackChecksum, error))
+				{
+					return false;
+				}
+				nextJoin = waited + joinRetry;
+			}
+			client.Receive();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		if (client.Refused())
+		{
+			error = "the server is full or racing on a different track";
+			return false;
+		}
+		return true;
+	}
+
+	RaceInput ClientAutopilot(const TrackData& track, const RaceClient& client, int frame)
+	{
+		bool finished = (client.Car(client.Player()).flags & NetCarFinished) != 0;
+		return AutopilotDrive(track, client.OwnCar(), client.Own().nextCheckpoint, finished, frame);
+	}
+
+	void PrintServerStats(const NetServerStats& stats, int clients)
+	{
+		double ticks = double(std::max(stats.ticks, 1LL));
+		printf("ticks: %lld\n", stats.ticks);
+		printf("clients: %d\n", clients);
+		printf("bytes per tick per client: %.1f down, %.1f up\n", stats.bytesSent / ticks / std::max(clients, 1), stats.bytesReceived / ticks / std::max(clients, 1));
+		printf("simulation: %.2f us per tick\n", stats.simSeconds / ticks * 1e6);
+		printf("network: %.2f us per tick\n", stats.netSeconds / ticks * 1e6);
+	}
+
+	int RunServer(const TrackData& track, RaceSettings settings, const NetAddress& local, int maxFrames)
+	{
+		RaceSimulation sim(track, settings);
+		RaceServer server;
+		std::string error;
+		if (!server.Open(sim, local, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		printf("serving %d players on port %u\n", sim.PlayerCount(), server.Port());
+
+		//Real time: tick whenever a tick's worth of time has gone, sleeping in between.
+		auto next = Clock::now();
+		auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(sim.TickTime()));
+		while (int(server.Tick()) < maxFrames && !(server.ClientCount() == sim.PlayerCount() && sim.Finished()))
+		{
+			server.Poll();
+			if (server.ClientCount() > 0)
+			{
+				server.Step();
+			}
+			next += tickLength;
+			std::this_thread::sleep_until(next);
+		}
+		printf("finished: %s\n", sim.Finished() ? "yes" : "no");
+		PrintServerStats(server.Stats(), server.ClientCount());
+		return 0;
+	}
+
+	int RunClient(const TrackData& track, const NetAddress& address)
+	{
+		RaceClient client;
+		std::string error;
+		if (!Connect(client, address, TrackChecksum(track), error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		printf("joined as player %d of %d cars\n", client.Player(), client.CarCount());
+
+		//An input goes back for every snapshot that comes in.
+		int frame = 0;
+		auto lastHeard = Clock::now();
+		while ((client.Car(client.Player()).flags & NetCarFinished) == 0)
+		{
+			if (client.Receive() > 0)
+			{
+				client.SendInput(ClientAutopilot(track, client, frame++));
+				lastHeard = Clock::now();
+			}
+			else if (std::chrono::duration<float>(Clock::now() - lastHeard).count() > serverSilence)
+			{
+				fprintf(stderr, "lost the server\n");
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		const NetCarView& car = client.Car(client.Player());
+		double snapshots = double(std::max(frame, 1));
+		printf("finished: %s\n", (car.flags & NetCarFinished) != 0 ? "yes" : "no");
+		printf("checkpoints: %d\n", car.gates);
+		printf("race time: %.2f s\n", client.Own().raceTime);
+		printf("health: %d\n", client.Own().health);
+		printf("bytes per snapshot: %.1f down, %.1f up\n", client.BytesReceived() / snapshots, client.BytesSent() / snapshots);
+		return 0;
+	}
+
+	//Server and clients in one thread, in lock step: the clients answer the last snapshot, the
+	//server reads the inputs, ticks and sends the next.  Only the server's side is timed.
+	int RunBench(const TrackData& track, int clientCount, int ticks, int maxCars)
+	{
+		printf("%8s %8s %14s %14s %18s %16s %12s\n", "cars", "clients", "sim us/tick", "net us/tick", "down bytes/tick", "up bytes/tick", "checkpoints");
+		for (int cars = 16; cars <= maxCars; cars *= 4)
+		{
+			RaceSettings settings;
+			settings.playerCount = clientCount;
+			settings.aiCarCount = std::max(cars - clientCount, 0);
+			RaceSimulation sim(track, settings);
+			RaceServer server;
+			std::string error;
+			NetAddress local;
+			local.ip = loopbackIp;
+			if (!server.Open(sim, local, error))
+			{
+				fprintf(stderr, "%s\n", error.c_str());
+				return 1;
+			}
+			NetAddress address;
+			address.ip = loopbackIp;
+			address.port = server.Port();
+
+			std::vector<std::unique_ptr<RaceClient>> clients;
+			for (int i = 0; i < clientCount; i++)
+			{
+				clients.emplace_back(new RaceClient());
+				if (!clients.back()->Join(address, TrackChecksum(track), error))
+				{
+					fprintf(stderr, "%s\n", error.c_str());
+					return 1;
+				}
+			}
+			server.Poll();
+			for (auto& client : clients)
+			{
+				client->Receive();
+				if (!client->Connected())
+				{
+					fprintf(stderr, "a client could not join over loopback\n");
+					return 1;
+				}
+			}
+
+			for (int frame = 0; frame < ticks; frame++)
+			{
+				for (auto& client : clients)
+				{
+					client->Receive();
+					client->SendInput(ClientAutopilot(track, *client, frame));
+				}
+				server.Poll();
+				server.Step();
+			}
+
+			const NetServerStats& stats = server.Stats();
+			int gates = 0; //Passed by the clients' cars, to show they really are racing.
+			for (int p = 0; p < sim.PlayerCount(); p++)
+			{
+				gates += sim.Laps().GatesPassed(p);
+			}
+			printf("%8d %8d %14.2f %14.2f %18.1f %16.1f %12.1f\n", sim.PlayerCount() + sim.Ai().Count(), clientCount,
+				stats.simSeconds / stats.ticks * 1e6, stats.netSeconds / stats.ticks * 1e6,
+				double(stats.bytesSent) / stats.ticks / clientCount, double(stats.bytesReceived) / stats.ticks / clientCount, double(gates) / clientCount);
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	enum Mode { ModeNone, ModeServer, ModeClient, ModeBench } mode = ModeNone;
+	std::string trackPath;
+	std::string host = "localhost";
+	uint16_t port = defaultRacePort;
+	int players = 1;
+	int aiCars = -1; //Keep the default.
+	int maxFrames = 60 * 60 * 5;
+	int clients = 4;
+	int ticks = 60 * 40;
+	int maxCars = 65536;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--server") == 0)
+		{
+			mode = ModeServer;
+		}
+		else if (strcmp(argv[i], "--client") == 0)
+		{
+			mode = ModeClient;
+		}
+		else if (strcmp(argv[i], "--bench") == 0)
+		{
+			mode = ModeBench;
+		}
+		else if (strcmp(argv[i], "--track") == 0 && i + 1 < argc)
+		{
+			trackPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+		{
+			host = argv[++i];
+		}
+		else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+		{
+			port = uint16_t(atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc)
+		{
+			players = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--ai-cars") == 0 && i + 1 < argc)
+		{
+			aiCars = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			maxFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc)
+		{
+			clients = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+		{
+			ticks = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+		{
+			maxCars = atoi(argv[++i]);
+		}
+		else
+		{
+			mode = ModeNone;
+			break;
+		}
+	}
+	if (mode == ModeNone || players < 1 || clients < 1)
+	{
+		printf("Usage: %s --server [--port N] [--players N] [--ai-cars N] [--frames N] [--track file]\n", argv[0]);
+		printf("       %s --client [--host ip] [--port N] [--track file]\n", argv[0]);
+		printf("       %s --bench [--clients N] [--ticks N] [--max cars] [--track file]\n", argv[0]);
+		return 1;
+	}
+
+	//Both ends must race on the same track; the join is refused otherwise.
+	LoadedTrack loadedTrack;
+	std::string error;
+	if (trackPath.empty())
+	{
+		loadedTrack.LoadDefault();
+	}
+	else if (!loadedTrack.Load(trackPath, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	const TrackData& track = loadedTrack.Data();
+
+	if (mode == ModeBench)
+	{
+		return RunBench(track, clients, ticks, maxCars);
+	}
+
+	NetAddress address;
+	if (!ParseNetAddress(host, port, address))
+	{
+		fprintf(stderr, "%s is not an IPv4 address\n", host.c_str());
+		return 1;
+	}
+	if (mode == ModeClient)
+	{
+		return RunClient(track, address);
+	}
+	RaceSettings settings;
+	settings.playerCount = players;
+	settings.aiCarCount = aiCars >= 0 ? aiCars : settings.aiCarCount;
+	return RunServer(track, settings, address, maxFrames);
+}
@@ -0,0 +1,144 @@
+// Jonathan Walsh
+#include "NetSocket.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+namespace
+{
+	sockaddr_in ToSockaddr(const NetAddress& address)
+	{
+		sockaddr_in result;
+		memset(&result, 0, sizeof(result));
+		result.sin_family = AF_INET;
+		result.sin_addr.s_addr = htonl(address.ip);
+		result.sin_port = htons(address.port);
+		return result;
+	}
+
+#ifdef _WIN32
+	//Winsock has to be started once before the first socket.
+	bool StartWinsock()
+	{
+		static bool started = false;
+		if (!started)
+		{
+			WSADATA data;
+			started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+		}
+		return started;
+	}
+#endif
+}
+
+bool ParseNetAddress(const std::string& host, uint16_t port, NetAddress& address)
+{
+	address.port = port;
+	if (host == "localhost")
+	{
+		address.ip = loopbackIp;
+		return true;
+	}
+	in_addr parsed;
+	if (inet_pton(AF_INET, host.c_str(), &parsed) != 1)
+	{
+		return false;
+	}
+	address.ip = ntohl(parsed.s_addr);
+	return true;
+}
+
+UdpSocket::~UdpSocket()
+{
+	Close();
+}
+
+bool UdpSocket::Open(const NetAddress& local, std::string& error)
+{
+	Close();
+#ifdef _WIN32
+	if (!StartWinsock())
+	{
+		error = "cannot start Winsock";
+		return false;
+	}
+#endif
+	handle = Handle(socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	if (handle == invalidHandle)
+	{
+		error = "cannot create a UDP socket";
+		return false;
+	}
+
+	sockaddr_in address = ToSockaddr(local);
+	if (bind(handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+	{
+		Close();
+		error = "cannot bind UDP port " + std::to_string(local.port);
+		return false;
+	}
+
+	//Receive never waits: the caller polls once a tick.
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	bool ready = ioctlsocket(handle, FIONBIO, &nonBlocking) == 0;
+#else
+	bool ready = fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+	socklen_t length = sizeof(address);
+	if (!ready || getsockname(handle, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+	{
+		Close();
+		error = "cannot set up the UDP socket";
+		return false;
+	}
+	port = ntohs(address.sin_port);
+	return true;
+}
+
+void UdpSocket::Close()
+{
+	if (handle != invalidHandle)
+	{
+#ifdef _WIN32
+		closesocket(handle);
+#else
+		close(handle);
+#endif
+	}
+	handle = invalidHandle;
+	port = 0;
+}
+
+bool UdpSocket::Send(const NetAddress& to, const void* data, int size)
+{
+	sockaddr_in address = ToSockaddr(to);
+	int sent = int(sendto(handle, static_cast<const char*>(data), size, 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+	return sent == size;
+}
+
+int UdpSocket::Receive(void* buffer, int size, NetAddress& from)
+{
+	sockaddr_in address;
+	socklen_t length = sizeof(address);
+	int received = int(recvfrom(handle, static_cast<char*>(buffer), size, 0, reinterpret_cast<sockaddr*>(&address), &length));
+	if (received <= 0)
+	{
+		return 0; //Nothing waiting, or an error such as the far end's port being closed.
+	}
+	from.ip = ntohl(address.sin_addr.s_addr);
+	from.port = ntohs(address.sin_port);
+	return received;
+}
@@ -0,0 +1,49 @@
+// Jonathan Walsh
+//A non-blocking UDP socket, over Winsock on Windows and BSD sockets everywhere else.
+#pragma once
+#include <cstdint>
+#include <string>
+
+//An IPv4 address and port, both in host byte order.
+struct NetAddress
+{
+	uint32_t ip = 0;
+	uint16_t port = 0;
+
+	bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+	bool operator!=(const NetAddress& other) const { return !(*this == other); }
+};
+
+const uint32_t loopbackIp = 0x7f000001; //127.0.0.1
+
+bool ParseNetAddress(const std::string& host, uint16_t port, NetAddress& address); //Dotted IPv4, or "localhost".
+
+class UdpSocket
+{
+public:
+	UdpSocket() {}
+	~UdpSocket();
+
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+
+	//Binds to the given address; port 0 picks any free port.
+	bool Open(const NetAddress& local, std::string& error);
+	void Close();
+	bool IsOpen() const { return handle != invalidHandle; }
+	uint16_t Port() const { return port; } //The port actually bound.
+
+	bool Send(const NetAddress& to, const void* data, int size);
+	int Receive(void* buffer, int size, NetAddress& from); //Bytes read, or 0 when nothing is waiting.
+
+private:
+#ifdef _WIN32
+	typedef uintptr_t Handle;
+	static const Handle invalidHandle = ~Handle(0);
+#else
+	typedef int Handle;
+	static const Handle invalidHandle = -1;
+#endif
+	Handle handle = invalidHandle;
+	uint16_t port = 0;
+};
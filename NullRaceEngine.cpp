@@ -0,0 +1,96 @@
+// Jonathan Walsh
+#include "NullRaceEngine.h"
+#include <cmath>
+
+NullRaceEngine::NullRaceEngine(const InputScript& script, float fixedFrameTime, int maxFrames)
+	: script(script), fixedFrameTime(fixedFrameTime), maxFrames(maxFrames)
+{
+}
+
+void NullRaceEngine::ReadInput(RaceInput& input)
+{
+	if (script)
+	{
+		input = script(frame);
+	}
+}
+
+void NullRaceEngine::Present(const RaceFrame& shown, float)
+{
+	frame++;
+	if (frame >= maxFrames || shown.Finished())
+	{
+		running = false; //Nothing left to simulate.
+	}
+}
+
+RaceInput AutopilotInput(const RaceSimulation& sim, int frame)
+{
+	return AutopilotDrive(sim.Track(), sim.Player(), sim.NextCheckpoint(), sim.Finished(), frame);
+}
+
+RaceInput AutopilotDrive(const TrackData& track, const CarState& car, int next, bool finished, int frame)
+{
+	const float radiansToDegrees = 180.0f / 3.14159265f;
+	const float steerDeadZone = 5.0f; //Degrees either side of the target that count as straight ahead.
+	const float sharpTurn = 30.0f; //Only thrust when roughly facing the right way.
+	const float checkpointRange = 30.0f; //Head straight for the next checkpoint once it is this close.
+	const float waypointReach = 4.0f; //Move on to the following waypoint once this close.
+	const float cruiseMomentum = 15.0f; //Stays slow enough to make the corners.
+
+	RaceInput input;
+	input.Set(StartHit, frame == 0);
+
+	if (finished || track.checkpointX.Count() == 0)
+	{
+		return input;
+	}
+
+	//Follow the AI waypoints around the obstacles, but aim for the middle of the next checkpoint when it is close.
+	float targetX = track.checkpointX[next];
+	float targetZ = track.checkpointZ[next];
+	float toCheckX = targetX - car.x;
+	float toCheckZ = targetZ - car.z;
+	if (toCheckX*toCheckX + toCheckZ * toCheckZ > checkpointRange*checkpointRange && track.waypointX.Count() > 0)
+	{
+		//The closest waypoint, or the one after it once the car is level with it or past it.
+		int closest = 0;
+		float bestDist = -1.0f;
+		for (int i = 0; i < track.waypointX.Count(); i++)
+		{
+			float dx = track.waypointX[i] - car.x;
+			float dz = track.waypointZ[i] - car.z;
+			float dist = dx * dx + dz * dz;
+			if (bestDist < 0.0f || dist < bestDist)
+			{
+				bestDist = dist;
+				closest = i;
+			}
+		}
+		int following = (closest + 1) % track.waypointX.Count();
+		float pastX = (car.x - track.waypointX[closest]) * (track.waypointX[following] - track.waypointX[closest]);
+		float pastZ = (car.z - track.waypointZ[closest]) * (track.waypointZ[following] - track.waypointZ[closest]);
+		if (bestDist < waypointReach*waypointReach || pastX + pastZ > 0.0f)
+		{
+			closest = following;
+		}
+		targetX = track.waypointX[closest];
+		targetZ = track.waypointZ[closest];
+	}
+
+	//The car slides like a hovercraft, so point the thrust at the difference between the
+	//velocity we want (straight at the target) and the momentum it already has.
+	float toX = targetX - car.x;
+	float toZ = targetZ - car.z;
+	float toLength = std::sqrt(toX*toX + toZ * toZ) + 0.001f;
+	float errorX = toX / toLength * cruiseMomentum - car.momentum.x;
+	float errorZ = toZ / toLength * cruiseMomentum - car.momentum.z;
+
+	//Turn towards the thrust direction, wrapping the angle into -180..180.
+	float targetYaw = std::atan2(errorX, errorZ) * radiansToDegrees;
+	float turn = std::fmod(targetYaw - car.yaw + 540.0f, 360.0f) - 180.0f;
+	input.Set(SteerRight, turn > steerDeadZone);
+	input.Set(SteerLeft, turn < -steerDeadZone);
+	input.Set(AccelForward, std::fabs(turn) < sharpTurn && errorX*errorX + errorZ * errorZ > 1.0f);
+	return input;
+}
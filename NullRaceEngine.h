@@ -0,0 +1,32 @@
+// Jonathan Walsh
+//Headless backend.  No window, no vsync: every frame takes a fixed frame time and the
+//controls come from a script, so races run as fast as the CPU allows.
+#pragma once
+#include "RaceEngine.h"
+#include <functional>
+
+typedef std::function<RaceInput(int frame)> InputScript; //Returns the controls for a frame.
+
+class NullRaceEngine : public IRaceEngine
+{
+public:
+	NullRaceEngine(const InputScript& script, float fixedFrameTime = 1.0f / 60.0f, int maxFrames = 60 * 60 * 5);
+
+	bool IsRunning() override { return running; }
+	float Timer() override { return fixedFrameTime; }
+	void ReadInput(RaceInput& input) override;
+	void Present(const RaceFrame& frame, float frameTime) override;
+	void Stop() override { running = false; }
+
+	int FramesRun() const { return frame; }
+
+private:
+	InputScript script;
+	float fixedFrameTime;
+	int maxFrames;
+	int frame = 0;
+	bool running = true;
+};
+
+RaceInput AutopilotInput(const RaceSimulation& sim, int frame); //Starts the race and drives at each checkpoint in turn.
+RaceInput AutopilotDrive(const TrackData& track, const CarState& car, int nextCheckpoint, bool finished, int frame); //The same for any car.
@@ -0,0 +1,226 @@
+// Jonathan Walsh
+#include "ObstacleStore.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OBSTACLE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OBSTACLE_SSE2 1
+#endif
+
+namespace
+{
+	const int laneBlock = 8; //Obstacles tested per mask.
+
+	unsigned SphereHitMaskScalar(const SphereObstacleView& spheres, int first, int count, float carX, float carZ)
+	{
+		unsigned mask = 0;
+		for (int lane = 0; lane < count; lane++)
+		{
+			int i = first + lane;
+			float distX = carX - spheres.x[i];
+			float distZ = carZ - spheres.z[i];
+			if (distX*distX + distZ * distZ < spheres.touchSq[i]) //Squared distances, so no square root.
+			{
+				mask |= 1u << lane;
+			}
+		}
+		return mask;
+	}
+
+	unsigned BoxHitMaskScalar(const BoxObstacleView& boxes, int first, int count, float carX, float carZ)
+	{
+		unsigned mask = 0;
+		for (int lane = 0; lane < count; lane++)
+		{
+			int i = first + lane;
+			if (carX > boxes.minX[i] && carX < boxes.maxX[i] && carZ > boxes.minZ[i] && carZ < boxes.maxZ[i])
+			{
+				mask |= 1u << lane;
+			}
+		}
+		return mask;
+	}
+}
+
+void SphereObstacles::Add(float newX, float newZ, float newRadius)
+{
+	x.push_back(newX);
+	z.push_back(newZ);
+	radius.push_back(newRadius);
+	touchSq.push_back(TouchDistanceSq(newRadius));
+}
+
+void SphereObstacles::Clear()
+{
+	x.clear();
+	z.clear();
+	radius.clear();
+	touchSq.clear();
+}
+
+SphereObstacleView SphereObstacles::View() const
+{
+	return { x.data(), z.data(), radius.data(), touchSq.data(), Count() };
+}
+
+void BoxObstacles::Add(float newX, float newZ, float width, float depth)
+{
+	x.push_back(newX);
+	z.push_back(newZ);
+	halfWidth.push_back(width / 2);
+	halfDepth.push_back(depth / 2);
+	minX.push_back(GrownMin(newX, width / 2));
+	maxX.push_back(GrownMax(newX, width / 2));
+	minZ.push_back(GrownMin(newZ, depth / 2));
+	maxZ.push_back(GrownMax(newZ, depth / 2));
+}
+
+void BoxObstacles::Clear()
+{
+	x.clear();
+	z.clear();
+	halfWidth.clear();
+	halfDepth.clear();
+	minX.clear();
+	maxX.clear();
+	minZ.clear();
+	maxZ.clear();
+}
+
+BoxObstacleView BoxObstacles::View() const
+{
+	return { x.data(), z.data(), halfWidth.data(), halfDepth.data(), minX.data(), maxX.data(), minZ.data(), maxZ.data(), Count() };
+}
+
+unsigned SphereHitMask8(const SphereObstacleView& spheres, int first, float carX, float carZ)
+{
+	int count = spheres.count - first;
+	if (count < laneBlock)
+	{
+		return count > 0 ? SphereHitMaskScalar(spheres, first, count, carX, carZ) : 0;
+	}
+
+#if defined(OBSTACLE_AVX2)
+	__m256 distX = _mm256_sub_ps(_mm256_set1_ps(carX), _mm256_loadu_ps(spheres.x + first));
+	__m256 distZ = _mm256_sub_ps(_mm256_set1_ps(carZ), _mm256_loadu_ps(spheres.z + first));
+	__m256 distSq = _mm256_add_ps(_mm256_mul_ps(distX, distX), _mm256_mul_ps(distZ, distZ));
+	return unsigned(_mm256_movemask_ps(_mm256_cmp_ps(distSq, _mm256_loadu_ps(spheres.touchSq + first), _CMP_LT_OQ)));
+#elif defined(OBSTACLE_SSE2)
+	unsigned mask = 0;
+	for (int half = 0; half < laneBlock; half += 4)
+	{
+		int i = first + half;
+		__m128 distX = _mm_sub_ps(_mm_set1_ps(carX), _mm_loadu_ps(spheres.x + i));
+		__m128 distZ = _mm_sub_ps(_mm_set1_ps(carZ), _mm_loadu_ps(spheres.z + i));
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(distX, distX), _mm_mul_ps(distZ, distZ));
+		mask |= unsigned(_mm_movemask_ps(_mm_cmplt_ps(distSq, _mm_loadu_ps(spheres.touchSq + i)))) << half;
+	}
+	return mask;
+#else
+	return SphereHitMaskScalar(spheres, first, laneBlock, carX, carZ);
+#endif
+}
+
+unsigned BoxHitMask8(const BoxObstacleView& boxes, int first, float carX, float carZ)
+{
+	int count = boxes.count - first;
+	if (count < laneBlock)
+	{
+		return count > 0 ? BoxHitMaskScalar(boxes, first, count, carX, carZ) : 0;
+	}
+
+#if defined(OBSTACLE_AVX2)
+	//Strictly inside the grown box on both axes, the same test as car2Box.
+	__m256 carXs = _mm256_set1_ps(carX);
+	__m256 carZs = _mm256_set1_ps(carZ);
+	__m256 insideX = _mm256_and_ps(_mm256_cmp_ps(carXs, _mm256_loadu_ps(boxes.minX + first), _CMP_GT_OQ),
+		_mm256_cmp_ps(carXs, _mm256_loadu_ps(boxes.maxX + first), _CMP_LT_OQ));
+	__m256 insideZ = _mm256_and_ps(_mm256_cmp_ps(carZs, _mm256_loadu_ps(boxes.minZ + first), _CMP_GT_OQ),
+		_mm256_cmp_ps(carZs, _mm256_loadu_ps(boxes.maxZ + first), _CMP_LT_OQ));
+	return unsigned(_mm256_movemask_ps(_mm256_and_ps(insideX, insideZ)));
+#elif defined(OBSTACLE_SSE2)
+	__m128 carXs = _mm_set1_ps(carX);
+	__m128 carZs = _mm_set1_ps(carZ);
+	unsigned mask = 0;
+	for (int half = 0; half < laneBlock; half += 4)
+	{
+		int i = first + half;
+		__m128 insideX = _mm_and_ps(_mm_cmpgt_ps(carXs, _mm_loadu_ps(boxes.minX + i)), _mm_cmplt_ps(carXs, _mm_loadu_ps(boxes.maxX + i)));
+		__m128 insideZ = _mm_and_ps(_mm_cmpgt_ps(carZs, _mm_loadu_ps(boxes.minZ + i)), _mm_cmplt_ps(carZs, _mm_loadu_ps(boxes.maxZ + i)));
+		mask |= unsigned(_mm_movemask_ps(_mm_and_ps(insideX, insideZ))) << half;
+	}
+	return mask;
+#else
+	return BoxHitMaskScalar(boxes, first, laneBlock, carX, carZ);
+#endif
+}
+
+int FindSphereHits(const SphereObstacleView& spheres, int begin, int end, float carX, float carZ, int* hits)
+{
+	int hitCount = 0;
+	for (int first = begin; first < end; first += laneBlock)
+	{
+		unsigned mask = SphereHitMask8(spheres, first, carX, carZ);
+		if (end - first < laneBlock)
+		{
+			mask &= (1u << (end - first)) - 1; //Ignore lanes past the end of the range.
+		}
+		for (int lane = 0; mask != 0; lane++, mask >>= 1)
+		{
+			if (mask & 1u)
+			{
+				hits[hitCount++] = first + lane;
+			}
+		}
+	}
+	return hitCount;
+}
+
+int FindBoxHits(const BoxObstacleView& boxes, int begin, int end, float carX, float carZ, float oldCarX, float oldCarZ,
+	int* hits, boxSide* sides)
+{
+	int hitCount = 0;
+	for (int first = begin; first < end; first += laneBlock)
+	{
+		unsigned mask = BoxHitMask8(boxes, first, carX, carZ);
+		if (end - first < laneBlock)
+		{
+			mask &= (1u << (end - first)) - 1;
+		}
+		for (int lane = 0; mask != 0; lane++, mask >>= 1)
+		{
+			if (mask & 1u)
+			{
+				//Hits are rare, so the side is only worked out for the lanes that were hit.
+				hits[hitCount] = first + lane;
+				sides[hitCount] = BoxSideHit(boxes, first + lane, oldCarX, oldCarZ);
+				hitCount++;
+			}
+		}
+	}
+	return hitCount;
+}
+
+boxSide BoxSideHit(const BoxObstacleView& boxes, int index, float oldCarX, float oldCarZ)
+{
+	//Works out which side has been hit.
+	if (oldCarX < boxes.minX[index])
+	{
+		return LeftSide;
+	}
+	else if (oldCarX > boxes.maxX[index])
+	{
+		return RightSide;
+	}
+	else if (oldCarZ < boxes.minZ[index])
+	{
+		return FrontSide;
+	}
+	else if (oldCarZ > boxes.maxZ[index])
+	{
+		return BackSide;
+	}
+	return NoSide; //Already inside the box last frame.
+}
@@ -0,0 +1,85 @@
+// Jonathan Walsh
+//Structure-of-arrays storage for the static obstacles and the SIMD kernels that test a car
+//against many of them at once.  Uses AVX2 (8 lanes) or SSE2 (4 lanes) when the compiler
+//targets them and falls back to plain loops otherwise.
+//
+//Every obstacle is stored already grown by the car's radius: a box keeps the edges a car's centre
+//cannot cross and a sphere the squared distance a car's centre touches it at, so the kernels only
+//compare.  The growing is done by the constexpr functions below, when a track is baked (and so in
+//its .htrk file) and at compile time for CompiledTrack, so both give the same numbers.
+#pragma once
+#include "RacePhysics.h"
+#include <vector>
+
+constexpr float GrownMin(float centre, float half) { return centre - (half + carRad); }
+constexpr float GrownMax(float centre, float half) { return centre + (half + carRad); }
+constexpr float TouchDistanceSq(float radius) { return (carRad + radius) * (carRad + radius); }
+
+//Read-only views, so the kernels work the same on owned arrays and on arrays mapped from a file.
+struct SphereObstacleView
+{
+	const float* x;
+	const float* z;
+	const float* radius;
+	const float* touchSq; //TouchDistanceSq of the radius.
+	int count;
+};
+
+struct BoxObstacleView
+{
+	const float* x;
+	const float* z;
+	const float* halfWidth;
+	const float* halfDepth;
+	const float* minX; //The box grown by the car's radius.
+	const float* maxX;
+	const float* minZ;
+	const float* maxZ;
+	int count;
+};
+
+class SphereObstacles
+{
+public:
+	void Add(float x, float z, float radius);
+	void Clear();
+	int Count() const { return int(x.size()); }
+	SphereObstacleView View() const;
+
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<float> radius;
+	std::vector<float> touchSq;
+};
+
+class BoxObstacles
+{
+public:
+	void Add(float x, float z, float width, float depth);
+	void Clear();
+	int Count() const { return int(x.size()); }
+	BoxObstacleView View() const;
+
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<float> halfWidth;
+	std::vector<float> halfDepth;
+	std::vector<float> minX;
+	std::vector<float> maxX;
+	std::vector<float> minZ;
+	std::vector<float> maxZ;
+};
+
+//Bit i of the result is set when the car overlaps obstacle first + i.  Tests up to 8 obstacles,
+//lanes past the end of the view are never set.
+unsigned SphereHitMask8(const SphereObstacleView& spheres, int first, float carX, float carZ);
+unsigned BoxHitMask8(const BoxObstacleView& boxes, int first, float carX, float carZ);
+
+//Writes the index of every obstacle in [begin, end) the car overlaps into hits and returns how many there were.
+//For boxes the side that was hit, worked out from the old position the same way as car2Box, goes into sides.
+int FindSphereHits(const SphereObstacleView& spheres, int begin, int end, float carX, float carZ, int* hits);
+int FindBoxHits(const BoxObstacleView& boxes, int begin, int end, float carX, float carZ, float oldCarX, float oldCarZ,
+	int* hits, boxSide* sides);
+
+//Same side rules as car2Box, for a box already known to be hit.
+boxSide BoxSideHit(const BoxObstacleView& boxes, int index, float oldCarX, float oldCarZ);
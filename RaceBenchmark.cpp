@@ -0,0 +1,667 @@
+// Jonathan Walsh
+//Microbenchmarks for the physics and collision code, written out as JSON so runs can be compared.
+//Each benchmark is repeated until it has run for --min-time seconds and reported as nanoseconds
+//per operation.  The scaling benchmarks run with 10 up to --max (default 1,000,000) obstacles or cars.
+//    RaceBenchmark [--json out.json] [--filter name] [--min-time seconds] [--max N]
+#include "AiCars.h"
+#include "CompiledTrack.h"
+#include "CullingBvh.h"
+#include "GhostLap.h"
+#include "NullRaceEngine.h"
+#include "ObstacleStore.h"
+#include "RacePhysics.h"
+#include "RaceSimulation.h"
+#include "SpatialGrid.h"
+#include "SweepAndPrune.h"
+#include "SweptCollision.h"
+#include "ThreadPool.h"
+#include "TrackData.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	//Stops the compiler throwing away a result nobody reads.
+	template <class T>
+	void KeepResult(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+	const int inputCount = 4096; //Random inputs cycled through, a power of two so the index is a mask.
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		long long n; //Obstacles or cars, 0 for the single primitives.
+		long long iterations;
+		double nsPerOp;
+		double itemsPerSecond; //n * ops per second for the scaling benchmarks, ops per second otherwise.
+	};
+
+	class BenchmarkRunner
+	{
+	public:
+		BenchmarkRunner(double minTime, const std::string& filter) : minTime(minTime), filter(filter) {}
+
+		bool Selected(const std::string& name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+		//Runs body(iterations) with more iterations until it takes minTime, and records the fastest rate.
+		void Run(const std::string& name, long long n, const std::function<void(long long)>& body)
+		{
+			if (!Selected(name))
+			{
+				return;
+			}
+			body(1); //Warm up.
+			long long iterations = 1;
+			double seconds = 0.0;
+			for (;;)
+			{
+				auto start = std::chrono::steady_clock::now();
+				body(iterations);
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (seconds >= minTime || iterations >= (1LL << 40))
+				{
+					break;
+				}
+				//Aim a little past minTime from what this run took.
+				double scale = seconds > 0.0 ? minTime * 1.2 / seconds : 100.0;
+				iterations = (long long)(iterations * std::min(std::max(scale, 2.0), 100.0));
+			}
+			BenchmarkResult result;
+			result.name = name;
+			result.n = n;
+			result.iterations = iterations;
+			result.nsPerOp = seconds * 1e9 / iterations;
+			result.itemsPerSecond = iterations * double(n > 0 ? n : 1) / seconds;
+			results.push_back(result);
+			fprintf(stderr, "%-28s n=%-8lld %14.1f ns/op\n", name.c_str(), n, result.nsPerOp);
+		}
+
+		bool WriteJson(FILE* file) const
+		{
+			fprintf(file, "{\n  \"benchmarks\": [\n");
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const BenchmarkResult& r = results[i];
+				fprintf(file, "    { \"name\": \"%s\", \"n\": %lld, \"iterations\": %lld, \"ns_per_op\": %.3f, \"items_per_second\": %.1f }%s\n",
+					r.name.c_str(), r.n, r.iterations, r.nsPerOp, r.itemsPerSecond, i + 1 < results.size() ? "," : "");
+			}
+			fprintf(file, "  ]\n}\n");
+			return ferror(file) == 0;
+		}
+
+	private:
+		double minTime;
+		std::string filter;
+		std::vector<BenchmarkResult> results;
+	};
+
+	//Random car positions, moves and speeds shared by the primitive benchmarks.
+	struct Inputs
+	{
+		std::vector<float> x, z, oldX, oldZ, speed;
+
+		explicit Inputs(std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+			std::uniform_real_distribution<float> step(-2.0f, 2.0f);
+			std::uniform_real_distribution<float> speeds(0.0f, 40.0f);
+			for (int i = 0; i < inputCount; i++)
+			{
+				x.push_back(position(random));
+				z.push_back(position(random));
+				oldX.push_back(x.back() + step(random));
+				oldZ.push_back(z.back() + step(random));
+				speed.push_back(speeds(random));
+			}
+		}
+	};
+
+	void PrimitiveBenchmarks(BenchmarkRunner& runner, const Inputs& in)
+	{
+		runner.Run("car2Box", 0, [&](long long iterations)
+		{
+			int sides = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				sides += car2Box(in.x[k], in.z[k], in.oldX[k], in.oldZ[k], carRad, 0.0f, 0.0f, wallWidth, wallDepth);
+			}
+			KeepResult(sides);
+		});
+		runner.Run("car2Sphere", 0, [&](long long iterations)
+		{
+			int hits = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				hits += car2Sphere(in.x[k], in.z[k], carRad, 0.0f, 0.0f, strutRad);
+			}
+			KeepResult(hits);
+		});
+		runner.Run("CheckpointPassed", 0, [&](long long iterations)
+		{
+			int passed = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				passed += CheckpointPassed(in.x[k], in.z[k], 0.0f, 0.0f, checkpointWidth, checkpointDepth);
+			}
+			KeepResult(passed);
+		});
+		runner.Run("CarDamage", 0, [&](long long iterations)
+		{
+			int health = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				health += CarDamage(in.speed[k], 100);
+			}
+			KeepResult(health);
+		});
+		runner.Run("Scalar", 0, [&](long long iterations)
+		{
+			vector2D total = { 0.0f, 0.0f };
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				vector2D v = Scalar(in.speed[k], { in.x[k], in.z[k] });
+				total.x += v.x;
+				total.z += v.z;
+			}
+			KeepResult(total);
+		});
+		runner.Run("Sum3", 0, [&](long long iterations)
+		{
+			vector2D total = { 0.0f, 0.0f };
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				total = Sum3(total, { in.x[k], in.z[k] }, { -total.x * 0.5f, -total.z * 0.5f });
+			}
+			KeepResult(total);
+		});
+		runner.Run("SweptCircleBox", 0, [&](long long iterations)
+		{
+			float time = 0.0f;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				time += SweptCircleBox(in.oldX[k], in.oldZ[k], in.x[k], in.z[k], carRad, 0.0f, 0.0f, wallWidth / 2, wallDepth / 2).time;
+			}
+			KeepResult(time);
+		});
+		runner.Run("SweptCircleCircle", 0, [&](long long iterations)
+		{
+			float time = 0.0f;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				time += SweptCircleCircle(in.oldX[k], in.oldZ[k], in.x[k], in.z[k], carRad, 0.0f, 0.0f, strutRad).time;
+			}
+			KeepResult(time);
+		});
+	}
+
+	//n walls scattered at a fixed density (about one per 400 square units), so a car always has a few nearby.
+	float AreaSide(int n)
+	{
+		return std::sqrt(float(n) * 400.0f);
+	}
+
+	int CollisionBenchmarks(BenchmarkRunner& runner, int n, std::mt19937& random)
+	{
+		float side = AreaSide(n);
+		std::uniform_real_distribution<float> position(0.0f, side);
+		BoxObstacles walls;
+		for (int i = 0; i < n; i++)
+		{
+			walls.Add(position(random), position(random), wallWidth, wallDepth);
+		}
+		std::vector<float> carX(inputCount), carZ(inputCount);
+		for (int i = 0; i < inputCount; i++)
+		{
+			carX[i] = position(random);
+			carZ[i] = position(random);
+		}
+		std::vector<int> hits(n);
+		std::vector<boxSide> sides(n);
+
+		//The original loop: car2Box against every wall.
+		runner.Run("walls_car2Box_loop", n, [&](long long iterations)
+		{
+			int total = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				for (int w = 0; w < n; w++)
+				{
+					total += car2Box(carX[k], carZ[k], carX[k], carZ[k], carRad, walls.x[w], walls.z[w], wallWidth, wallDepth) != NoSide;
+				}
+			}
+			KeepResult(total);
+		});
+
+		//Every wall through the SIMD kernel.
+		BoxObstacleView view = walls.View();
+		runner.Run("walls_simd_kernel", n, [&](long long iterations)
+		{
+			int total = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				total += FindBoxHits(view, 0, n, carX[k], carZ[k], carX[k], carZ[k], hits.data(), sides.data());
+			}
+			KeepResult(total);
+		});
+
+		//Only the walls in the grid cells under the car, the way the game does it.
+		SpatialGrid grid;
+		BuildGrid(walls, grid);
+		view = walls.View();
+		GridView gridView = grid.View();
+
+		int mismatches = 0;
+		if (runner.Selected("walls_grid_pass"))
+		{
+			//Before timing, the grid's hits are checked against every wall's, from points over the area and
+			//past each side and corner of the grid, and from ones far enough off to overflow a cell index.
+			unsigned pointSeed = unsigned(n);
+			std::mt19937 pointRandom(pointSeed);
+			std::uniform_real_distribution<float> around(-side / 2, side * 1.5f);
+			std::vector<float> checkX, checkZ;
+			for (int i = 0; i < 256; i++)
+			{
+				checkX.push_back(around(pointRandom));
+				checkZ.push_back(around(pointRandom));
+			}
+			const float far[] = { -1e30f, -1e10f, -side, side * 2, 1e10f, 1e30f, -INFINITY, INFINITY };
+			for (float a : far)
+			{
+				for (float b : { a, side / 2, -carRad / 2, side + carRad / 2 })
+				{
+					checkX.push_back(a);
+					checkZ.push_back(b);
+					checkX.push_back(b);
+					checkZ.push_back(a);
+				}
+			}
+			std::vector<int> fromGrid, fromAll;
+			for (size_t k = 0; k < checkX.size(); k++)
+			{
+				int found = 0;
+				gridView.ForEachRange(checkX[k], checkZ[k], carRad, [&](GridRange range)
+				{
+					found += FindBoxHits(view, range.begin, range.end, checkX[k], checkZ[k], checkX[k], checkZ[k], hits.data() + found, sides.data() + found);
+				});
+				fromGrid.assign(hits.begin(), hits.begin() + found);
+				std::sort(fromGrid.begin(), fromGrid.end());
+				found = FindBoxHits(view, 0, n, checkX[k], checkZ[k], checkX[k], checkZ[k], hits.data(), sides.data());
+				fromAll.assign(hits.begin(), hits.begin() + found);
+				std::sort(fromAll.begin(), fromAll.end());
+				mismatches += fromGrid != fromAll;
+			}
+			if (mismatches > 0)
+			{
+				fprintf(stderr, "walls_grid_pass: %d of %d points differ from testing every wall with n=%d\n", mismatches, int(checkX.size()), n);
+			}
+		}
+
+		runner.Run("walls_grid_pass", n, [&](long long iterations)
+		{
+			int total = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				int k = int(i) & (inputCount - 1);
+				int found = 0;
+				gridView.ForEachRange(carX[k], carZ[k], carRad, [&](GridRange range)
+				{
+					found += FindBoxHits(view, range.begin, range.end, carX[k], carZ[k], carX[k], carZ[k], hits.data() + found, sides.data() + found);
+				});
+				total += found;
+			}
+			KeepResult(total);
+		});
+
+		runner.Run("walls_grid_build", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				BuildGrid(walls, grid);
+			}
+			KeepResult(grid);
+		});
+		return mismatches;
+	}
+
+	void CarBenchmarks(BenchmarkRunner& runner, int n, std::mt19937& random)
+	{
+		float side = AreaSide(n);
+		std::uniform_real_distribution<float> position(0.0f, side);
+		std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+		std::vector<float> x(n), z(n);
+		for (int i = 0; i < n; i++)
+		{
+			x[i] = position(random);
+			z[i] = position(random);
+		}
+
+		//Cars move a little every frame, so the order from the frame before is nearly right.
+		SweepAndPrune sweep;
+		sweep.Resize(n);
+		std::vector<CarPair> pairs;
+		pairs.reserve(n * 2);
+		sweep.FindPairs(z.data(), x.data(), carRad, pairs);
+		std::vector<float> moveX(n), moveZ(n);
+		for (int i = 0; i < n; i++)
+		{
+			moveX[i] = jitter(random);
+			moveZ[i] = jitter(random);
+		}
+		runner.Run("cars_sweep_and_prune", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				float sign = (i & 1) != 0 ? -1.0f : 1.0f;
+				for (int c = 0; c < n; c++)
+				{
+					x[c] += moveX[c] * sign;
+					z[c] += moveZ[c] * sign;
+				}
+				pairs.clear();
+				sweep.FindPairs(z.data(), x.data(), carRad, pairs);
+			}
+			KeepResult(pairs);
+		});
+
+		//The racing line follower over the default track's line.
+		RaceTrack source = DefaultTrack();
+		BakedTrack track(source);
+		AiCars cars;
+		for (int i = 0; i < n; i++)
+		{
+			cars.Add(x[i] / side * 70.0f, z[i] / side * 175.0f);
+		}
+		runner.Run("ai_update", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				cars.Update(track.Data().racingLine, true, 30.0f, 8.0f, 1.0f / 60.0f, true);
+			}
+			KeepResult(cars);
+		});
+
+		//A whole tick of the race with n AI cars on the default track.
+		RaceSettings settings;
+		settings.aiCarCount = n;
+		settings.aiGridColumns = 8;
+		RaceSimulation sim(track.Data(), settings);
+		RaceInput start;
+		start.Set(StartHit, true);
+		sim.Step(start);
+		RaceInput drive;
+		drive.Set(AccelForward, true);
+		runner.Run("race_tick", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				sim.Step(drive);
+			}
+			KeepResult(sim);
+		});
+
+		//The same with the AI cars and the car sweep split across every core.
+		ThreadPool workers;
+		RaceSimulation splitSim(track.Data(), settings);
+		splitSim.SetWorkers(&workers);
+		splitSim.Step(start);
+		runner.Run("race_tick_workers", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				splitSim.Step(drive);
+			}
+			KeepResult(splitSim);
+		});
+	}
+
+	//n wall models at the same density as the collision benchmarks, seen from a chase camera in the
+	//middle, turning a little every frame.  The tree against testing every model's sphere.  Before
+	//timing, the tree's answer for those views and for random ones from anywhere over the area,
+	//pitched up or down, is checked against the sphere tests; returns how many views differed.
+	int CullingBenchmarks(BenchmarkRunner& runner, int n, std::mt19937& random)
+	{
+		float side = AreaSide(n);
+		std::uniform_real_distribution<float> position(0.0f, side);
+		std::vector<float> x(n), y(n, 0.0f), z(n), radius(n, 6.0f);
+		for (int i = 0; i < n; i++)
+		{
+			x[i] = position(random);
+			z[i] = position(random);
+		}
+		CullingBvh bvh;
+		bvh.Build(x.data(), y.data(), z.data(), radius.data(), n);
+
+		const int views = 64;
+		std::vector<ViewFrustum> frustums;
+		for (int v = 0; v < views; v++)
+		{
+			float yaw = 6.2831853f * v / views;
+			float matrix[16] = { std::cos(yaw), 0.0f, -std::sin(yaw), 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+				std::sin(yaw), 0.0f, std::cos(yaw), 0.0f, side / 2, 10.0f, side / 2, 1.0f };
+			frustums.push_back(ViewFrustum::FromCamera(matrix, 60.0f, 4.0f / 3.0f, 0.0f, maxDistance));
+		}
+
+		int mismatches = 0;
+		if (runner.Selected("cull_bvh"))
+		{
+			//Own generator, so the check does not change the inputs of the benchmarks after it.
+			unsigned viewSeed = unsigned(n);
+			std::mt19937 viewRandom(viewSeed);
+			std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+			std::uniform_real_distribution<float> height(-20.0f, 60.0f);
+			std::vector<ViewFrustum> checked = frustums;
+			for (int v = 0; v < views; v++)
+			{
+				float yaw = angle(viewRandom);
+				float pitch = angle(viewRandom) / 4;
+				float forward[3] = { std::sin(yaw) * std::cos(pitch), -std::sin(pitch), std::cos(yaw) * std::cos(pitch) };
+				float right[3] = { std::cos(yaw), 0.0f, -std::sin(yaw) };
+				float up[3] = { forward[1] * right[2] - forward[2] * right[1], forward[2] * right[0] - forward[0] * right[2], forward[0] * right[1] - forward[1] * right[0] };
+				float matrix[16] = { right[0], right[1], right[2], 0.0f, up[0], up[1], up[2], 0.0f, forward[0], forward[1], forward[2], 0.0f,
+					position(viewRandom), height(viewRandom), position(viewRandom), 1.0f };
+				checked.push_back(ViewFrustum::FromCamera(matrix, 60.0f, 4.0f / 3.0f, 0.0f, maxDistance));
+			}
+			std::vector<int> fromTree, fromSpheres;
+			for (const ViewFrustum& frustum : checked)
+			{
+				fromTree.clear();
+				bvh.Query(frustum, fromTree);
+				std::sort(fromTree.begin(), fromTree.end());
+				fromSpheres.clear();
+				for (int m = 0; m < n; m++)
+				{
+					if (frustum.TestSphere(x[m], y[m], z[m], radius[m]))
+					{
+						fromSpheres.push_back(m);
+					}
+				}
+				mismatches += fromTree != fromSpheres;
+			}
+			if (mismatches > 0)
+			{
+				fprintf(stderr, "cull_bvh: %d of %d views differ from testing every sphere with n=%d\n", mismatches, int(checked.size()), n);
+			}
+		}
+
+		std::vector<int> visible;
+		visible.reserve(n);
+		runner.Run("cull_bvh", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				visible.clear();
+				bvh.Query(frustums[i % views], visible);
+			}
+			KeepResult(visible);
+		});
+		runner.Run("cull_brute_force", n, [&](long long iterations)
+		{
+			for (long long i = 0; i < iterations; i++)
+			{
+				const ViewFrustum& frustum = frustums[i % views];
+				visible.clear();
+				for (int m = 0; m < n; m++)
+				{
+					if (frustum.TestSphere(x[m], y[m], z[m], radius[m]))
+					{
+						visible.push_back(m);
+					}
+				}
+			}
+			KeepResult(visible);
+		});
+		return mismatches;
+	}
+
+	//Getting the default track ready to race: baked from its layout when it loads, or from the tables
+	//compiled into the program, which leaves only the racing line to build.
+	void TrackBenchmarks(BenchmarkRunner& runner)
+	{
+		runner.Run("track_bake_default", 0, [&](long long iterations)
+		{
+			int walls = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				BakedTrack track(DefaultTrack());
+				walls += track.Data().walls.count;
+			}
+			KeepResult(walls);
+		});
+
+		runner.Run("track_compiled_default", 0, [&](long long iterations)
+		{
+			int walls = 0;
+			for (long long i = 0; i < iterations; i++)
+			{
+				CompiledTrack<defaultTrackSource> track;
+				walls += track.Data().walls.count;
+			}
+			KeepResult(walls);
+		});
+	}
+
+	//n ghosts of the autopilot's lap on the default track, each drawn once a frame.
+	void GhostBenchmarks(BenchmarkRunner& runner, int n)
+	{
+		BakedTrack track(DefaultTrack());
+		RaceSimulation sim(track.Data());
+		GhostRecorder recorder(track.Data(), sim.TickTime());
+		for (int frame = 0; frame < 60 * 60 * 5 && !sim.Finished(); frame++)
+		{
+			sim.Advance(AutopilotInput(sim, frame), 1.0f / 60.0f, [&] { recorder.Record(sim); });
+		}
+		if (recorder.Laps().empty())
+		{
+			return;
+		}
+		const GhostLap& lap = recorder.Laps()[0];
+		std::vector<GhostPlayer> ghosts(n);
+		for (GhostPlayer& ghost : ghosts)
+		{
+			ghost.Start(&lap);
+		}
+		int lapFrames = int(lap.LapTime() * 60.0f);
+		runner.Run("ghost_playback", n, [&](long long iterations)
+		{
+			float sum = 0.0f;
+			for (long long i = 0; i < iterations; i++)
+			{
+				float time = float(i % lapFrames) / 60.0f; //Round the lap again and again, restarting each time.
+				for (GhostPlayer& ghost : ghosts)
+				{
+					sum += ghost.Pose(time).x;
+				}
+			}
+			KeepResult(sum);
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string jsonPath;
+	std::string filter;
+	double minTime = 0.1;
+	int maxCount = 1000000;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+		{
+			minTime = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+		{
+			maxCount = atoi(argv[++i]);
+		}
+		else
+		{
+			printf("Usage: %s [--json out.json] [--filter name] [--min-time seconds] [--max N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	BenchmarkRunner runner(minTime, filter);
+	std::mt19937 random(1);
+	Inputs inputs(random);
+	PrimitiveBenchmarks(runner, inputs);
+	TrackBenchmarks(runner);
+	int mismatches = 0;
+	for (int n = 10; n <= maxCount; n *= 10)
+	{
+		mismatches += CollisionBenchmarks(runner, n, random);
+		CarBenchmarks(runner, n, random);
+		mismatches += CullingBenchmarks(runner, n, random);
+		if (n <= 1000)
+		{
+			GhostBenchmarks(runner, n);
+		}
+	}
+
+	//Progress went to stderr, so stdout is only the JSON.
+	FILE* file = jsonPath.empty() ? stdout : fopen(jsonPath.c_str(), "w");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+		return 1;
+	}
+	bool written = runner.WriteJson(file);
+	if (file != stdout)
+	{
+		written = fclose(file) == 0 && written;
+	}
+	return written && mismatches == 0 ? 0 : 1; //A grid or culling tree that disagrees with testing everything fails the run.
+}
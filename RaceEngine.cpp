@@ -0,0 +1,174 @@
+// Jonathan Walsh
+#include "RaceEngine.h"
+#include "FrameProfiler.h"
+#include "GhostLap.h"
+#include "InputLog.h"
+#include "Telemetry.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	//One frame of the race: the ticks, the recording that goes with them, and the frame to show.
+	void SimulateFrame(RaceSimulation& sim, const RaceInput& input, float frameTime, TelemetryWriter* telemetry, GhostRecorder* ghosts, RaceFrame& frame)
+	{
+		//Whole physics ticks, the rest carries over to the next frame.  Ghosts sample every tick.
+		sim.Advance(input, frameTime, [&]
+		{
+			if (ghosts != nullptr)
+			{
+				ghosts->Record(sim);
+			}
+		});
+		if (telemetry != nullptr)
+		{
+			telemetry->Record(sim);
+		}
+		frame.Capture(sim);
+	}
+
+	//Runs SimulateFrame on a thread of its own.  Start hands it a frame, Wait blocks until it is done;
+	//between the two nothing else may touch the simulation or the frame it is writing.
+	class SimulationThread
+	{
+	public:
+		SimulationThread(RaceSimulation& sim, TelemetryWriter* telemetry, GhostRecorder* ghosts)
+			: sim(sim), telemetry(telemetry), ghosts(ghosts)
+		{
+#if RACE_PROFILE
+			profiler = FrameProfiler::Current(); //The simulation phases go into the same frames as the rest.
+#endif
+			thread = std::thread(&SimulationThread::Loop, this);
+		}
+
+		~SimulationThread()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stopping = true;
+			}
+			wake.notify_one();
+			thread.join();
+		}
+
+		void Start(const RaceInput& frameInput, float time, RaceFrame& into)
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				input = frameInput;
+				frameTime = time;
+				frame = &into;
+				busy = true;
+			}
+			wake.notify_one();
+		}
+
+		void Wait()
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			done.wait(guard, [this] { return !busy; });
+		}
+
+	private:
+		void Loop()
+		{
+#if RACE_PROFILE
+			FrameProfiler::Install(profiler);
+#endif
+			std::unique_lock<std::mutex> guard(lock);
+			for (;;)
+			{
+				wake.wait(guard, [this] { return stopping || busy; });
+				if (stopping)
+				{
+					return;
+				}
+				guard.unlock();
+				SimulateFrame(sim, input, frameTime, telemetry, ghosts, *frame);
+				guard.lock();
+				busy = false;
+				done.notify_one();
+			}
+		}
+
+		RaceSimulation& sim;
+		TelemetryWriter* telemetry;
+		GhostRecorder* ghosts;
+#if RACE_PROFILE
+		FrameProfiler* profiler = nullptr;
+#endif
+
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		RaceInput input;
+		float frameTime = 0.0f;
+		RaceFrame* frame = nullptr;
+		bool busy = false;
+		bool stopping = false;
+		std::thread thread;
+	};
+}
+
+void RunRace(IRaceEngine& engine, RaceSimulation& sim, InputRecorder* recorder, TelemetryWriter* telemetry, GhostRecorder* ghosts, bool pipelined)
+{
+	//Double buffered: the engine shows one frame while the simulation thread writes the next into the other.
+	RaceFrame frames[2];
+	int shown = 0;
+	std::unique_ptr<SimulationThread> simThread;
+	if (pipelined)
+	{
+		frames[shown].Capture(sim); //The grid, shown while the first frame is simulated.
+		simThread.reset(new SimulationThread(sim, telemetry, ghosts));
+	}
+
+	float frameTime = engine.Timer(); // Timer initialised.
+	while (engine.IsRunning())
+	{
+		frameTime = engine.Timer();
+
+		RaceInput input;
+		{
+			PROFILE_SCOPE(PhaseInput);
+			engine.ReadInput(input);
+		}
+		if (recorder != nullptr)
+		{
+			recorder->Record(frameTime, input);
+		}
+
+		if (simThread)
+		{
+			simThread->Start(input, frameTime, frames[1 - shown]);
+			engine.Present(frames[shown], frameTime);
+			simThread->Wait();
+			shown = 1 - shown;
+			if (sim.OutOfBounds())
+			{
+				engine.Stop();//Game closes if you leave the course.
+			}
+		}
+		else
+		{
+			SimulateFrame(sim, input, frameTime, telemetry, ghosts, frames[shown]);
+			if (sim.OutOfBounds())
+			{
+				engine.Stop();//Game closes if you leave the course.
+			}
+			engine.Present(frames[shown], frameTime);
+		}
+		PROFILE_FRAME_END();
+	}
+	simThread.reset();
+
+	if (recorder != nullptr)
+	{
+		recorder->Close(sim);
+	}
+	if (telemetry != nullptr)
+	{
+		telemetry->Close();
+	}
+}
@@ -0,0 +1,32 @@
+// Jonathan Walsh
+//The thin layer between the race simulation and whatever is drawing it.
+//TLRaceEngine drives the real TL-Engine window, NullRaceEngine runs with no window at all
+//and ReplayRaceEngine plays back a recorded race.
+#pragma once
+#include "RaceFrame.h"
+
+class GhostRecorder;
+class InputRecorder;
+class TelemetryWriter;
+
+class IRaceEngine
+{
+public:
+	virtual ~IRaceEngine() {}
+
+	virtual bool IsRunning() = 0;
+	virtual float Timer() = 0; //Seconds since the last call.
+	virtual void ReadInput(RaceInput& input) = 0; //Fills in this frame's controls.
+	virtual void Present(const RaceFrame& frame, float frameTime) = 0; //Shows the result of a simulated frame.
+	virtual void Stop() = 0;
+};
+
+//The main game loop, repeats until the engine is stopped.  Every frame's time and input go to the recorder if there is one,
+//every car's state to the telemetry and the player's laps to the ghost recorder.
+//
+//Pipelined, each frame's ticks (and the telemetry and ghost recording) run on a thread of their
+//own while the engine presents the frame before, so the simulation is hidden behind drawing at
+//the cost of showing everything a frame later.  The simulation sees the same inputs and frame
+//times either way, so a pipelined race replays the same as any other.
+void RunRace(IRaceEngine& engine, RaceSimulation& sim, InputRecorder* recorder = nullptr, TelemetryWriter* telemetry = nullptr, GhostRecorder* ghosts = nullptr,
+	bool pipelined = false);
@@ -0,0 +1,39 @@
+// Jonathan Walsh
+#include "RaceFrame.h"
+#include <algorithm>
+
+void RaceFrame::Capture(const RaceSimulation& sim)
+{
+	int playerCount = sim.PlayerCount();
+	players.resize(playerCount);
+	playerPoses.resize(playerCount);
+	for (int p = 0; p < playerCount; p++)
+	{
+		players[p] = sim.Player(p);
+		playerPoses[p] = sim.PlayerPose(p);
+	}
+	aiPoses.resize(sim.Ai().Count());
+	for (int i = 0; i < int(aiPoses.size()); i++)
+	{
+		aiPoses[i] = sim.AiPose(i);
+	}
+
+	status = sim.Status();
+	state = sim.State();
+	raceTime = sim.RaceTime();
+	frameCount = sim.FrameCount();
+
+	//Timed from when the first player started the lap they are on, and carried on between ticks while racing.
+	const LapTracker& laps = sim.Laps();
+	float lapStart = 0.0f;
+	if (laps.Gates() > 0)
+	{
+		int lap = std::min(laps.Lap(0), laps.Laps() - 1);
+		lapStart = lap > 0 ? laps.Splits(0)[lap * laps.Gates() - 1] : 0.0f;
+	}
+	lapTime = raceTime - lapStart;
+	if (sim.GameStarted() && !sim.Finished())
+	{
+		lapTime += sim.Interpolation() * sim.TickTime();
+	}
+}
@@ -0,0 +1,36 @@
+// Jonathan Walsh
+//What one frame shows, copied out of the simulation once the frame's ticks have run: every car
+//where it is drawn, the players' cars and the race status.  Engines draw from this rather than
+//from the simulation, so the next frame can be simulated on another thread while this one is drawn.
+#pragma once
+#include "RaceSimulation.h"
+#include <vector>
+
+class RaceFrame
+{
+public:
+	void Capture(const RaceSimulation& sim); //Reuses its arrays, so only the first capture allocates.
+
+	const CarPose& PlayerPose(int player = 0) const { return playerPoses[player]; }
+	const CarPose& AiPose(int car) const { return aiPoses[car]; }
+	int PlayerCount() const { return int(players.size()); }
+	int AiCount() const { return int(aiPoses.size()); }
+
+	const CarState& Player(int player = 0) const { return players[player]; }
+	const RaceStatus& Status() const { return status; }
+	RaceState State() const { return state; }
+	bool Finished() const { return state == StateFinished; }
+	float RaceTime() const { return raceTime; }
+	float LapTime() const { return lapTime; } //Seconds into the first player's current lap, between ticks.
+	int FrameCount() const { return frameCount; }
+
+private:
+	std::vector<CarState> players;
+	std::vector<CarPose> playerPoses;
+	std::vector<CarPose> aiPoses;
+	RaceStatus status = { "", -1, "" };
+	RaceState state = StateWaiting;
+	float raceTime = 0.0f;
+	float lapTime = 0.0f;
+	int frameCount = 0;
+};
@@ -0,0 +1,159 @@
+// Jonathan Walsh
+#include "RaceHud.h"
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const long long neverShown = -1; //Forces the first Update to format every field.
+
+	//Positions of text
+	const int speedReadOutYPos = 20;
+	const int xBoostDisplayPos = 500;
+	const int alertXPos = 250;
+	const int alertYPos = 20;
+	const int healthXPos = 250;
+
+	//Whole number the same way the old stringstream fixed/setprecision(0) output was.
+	long long WholeNumber(float value)
+	{
+		return (long long)std::floor(value + 0.5f);
+	}
+}
+
+int FormatInt(char* out, long long value)
+{
+	char digits[24];
+	int count = 0;
+	unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+	do
+	{
+		digits[count++] = char('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	int length = 0;
+	if (value < 0)
+	{
+		out[length++] = '-';
+	}
+	while (count > 0)
+	{
+		out[length++] = digits[--count]; //Digits come out backwards.
+	}
+	return length;
+}
+
+int FormatFixed(char* out, float value, int decimals)
+{
+	long long scale = 1;
+	for (int i = 0; i < decimals; i++)
+	{
+		scale *= 10;
+	}
+	long long scaled = (long long)std::floor(std::fabs(value) * scale + 0.5f);
+
+	int length = 0;
+	if (value < 0.0f && scaled != 0)
+	{
+		out[length++] = '-';
+	}
+	length += FormatInt(out + length, scaled / scale);
+	if (decimals > 0)
+	{
+		out[length++] = '.';
+		long long fraction = scaled % scale;
+		for (long long digit = scale / 10; digit > 0; digit /= 10)
+		{
+			out[length++] = char('0' + fraction / digit % 10); //Keeps the leading zeros.
+		}
+	}
+	return length;
+}
+
+RaceHud::RaceHud()
+{
+	const int positions[HudFieldCount][2] = {
+		{ 0, 0 }, //Status
+		{ 0, speedReadOutYPos }, //Speed
+		{ healthXPos, 0 }, //Health
+		{ xBoostDisplayPos, 0 }, //Boost
+		{ alertXPos, alertYPos }, //Overheat alert
+		{ alertXPos, alertYPos }, //Overheated alert
+	};
+	for (int i = 0; i < HudFieldCount; i++)
+	{
+		fields[i].text.reserve(hudTextCapacity);
+		fields[i].x = positions[i][0];
+		fields[i].y = positions[i][1];
+		fields[i].visible = false;
+		fields[i].lastValue = neverShown;
+	}
+
+	//The alerts never change wording, only whether they are shown.
+	fields[HudOverheatAlert].text = "***ALERT!  OVERHEAT IMMINENT!***";
+	fields[HudOverheatedAlert].text = "***ENGINE OVERHEATED!!***";
+}
+
+void RaceHud::SetText(HudField& field, const char* prefix, long long number, long long value)
+{
+	field.visible = true;
+	if (field.lastValue == value)
+	{
+		return; //Nothing has changed since last frame.
+	}
+	field.lastValue = value;
+	reformats++;
+
+	char buffer[hudTextCapacity];
+	int length = int(strlen(prefix));
+	memcpy(buffer, prefix, length);
+	length += FormatInt(buffer + length, number);
+	field.text.assign(buffer, length); //Fits in the reserved space, so no allocation.
+}
+
+void RaceHud::Update(const RaceFrame& frame)
+{
+	const CarState& player = frame.Player();
+
+	//Countdown and stage text only changes when the simulation points at a different literal or number.
+	HudField& status = fields[HudStatus];
+	status.visible = true;
+	const RaceStatus& raceStatus = frame.Status();
+	if (lastStatus.text != raceStatus.text || lastStatus.number != raceStatus.number || lastStatus.after != raceStatus.after)
+	{
+		lastStatus = raceStatus;
+		char buffer[hudTextCapacity];
+		int length = int(strlen(raceStatus.text));
+		memcpy(buffer, raceStatus.text, length);
+		if (raceStatus.number >= 0)
+		{
+			length += FormatInt(buffer + length, raceStatus.number);
+		}
+		int afterLength = int(strlen(raceStatus.after));
+		memcpy(buffer + length, raceStatus.after, afterLength);
+		status.text.assign(buffer, length + afterLength);
+		reformats++;
+	}
+
+	long long speed = WholeNumber(player.speed);
+	SetText(fields[HudSpeed], "Speed: ", speed, speed);
+
+	SetText(fields[HudHealth], "Car Health: ", player.health, player.health);
+
+	//Shows boost time, or recovery time once the engine has overheated.  The mode is folded into the value.
+	if (player.boostDuration > 0.0f)
+	{
+		long long boost = WholeNumber(player.boostDuration);
+		SetText(fields[HudBoost], "Boost time: ", boost, boost * 2);
+	}
+	else
+	{
+		long long recovery = WholeNumber(player.overheatDuration);
+		SetText(fields[HudBoost], "Recovery time: ", recovery, recovery * 2 + 1);
+	}
+
+	//Shows alert message when there is risk of overheating, and once it has.
+	fields[HudOverheatAlert].visible = player.boostDuration < 1.0f && player.boostDuration > 0.0f;
+	fields[HudOverheatedAlert].visible = player.overheatDuration < 5.0f && player.overheatDuration > 0.0f;
+}
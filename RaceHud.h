@@ -0,0 +1,42 @@
+// Jonathan Walsh
+//On screen text for the race.  Every field keeps a string with its room reserved up front and
+//the value it was last formatted from, so text is only rebuilt when the number behind it
+//changes and never needs the heap once the race is running.
+#pragma once
+#include "RaceFrame.h"
+#include <string>
+
+const int hudTextCapacity = 64; //Longest text any field can hold.
+
+//Writes value as decimal digits into out (no terminator) and returns how many characters were written.
+int FormatInt(char* out, long long value);
+//Writes value with a fixed number of decimal places, rounded to nearest, e.g. FormatFixed(out, 2.346f, 2) gives "2.35".
+int FormatFixed(char* out, float value, int decimals);
+
+struct HudField
+{
+	std::string text;
+	int x;
+	int y;
+	bool visible;
+	long long lastValue; //What the text was last formatted from.
+};
+
+enum HudFieldId { HudStatus, HudSpeed, HudHealth, HudBoost, HudOverheatAlert, HudOverheatedAlert, HudFieldCount };
+
+class RaceHud
+{
+public:
+	RaceHud();
+
+	void Update(const RaceFrame& frame); //Reformats only the fields whose value has changed.
+	const HudField& Field(int id) const { return fields[id]; }
+	long long Reformats() const { return reformats; } //How many times any field's text has been rebuilt.
+
+private:
+	void SetText(HudField& field, const char* prefix, long long number, long long value);
+
+	HudField fields[HudFieldCount];
+	RaceStatus lastStatus = { nullptr, -1, nullptr }; //What the status text was last built from.
+	long long reformats = 0;
+};
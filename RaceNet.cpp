@@ -0,0 +1,646 @@
+// Jonathan Walsh
+#include "RaceNet.h"
+#include "InputLog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const float positionScale = 16.0f; //Positions are sent in sixteenths of a unit.
+	const float yawScale = 65536.0f / 360.0f;
+	const float momentumScale = 256.0f;
+	const float timeScale = 100.0f; //Times are sent in hundredths of a second.
+	const uint32_t historyMask = netHistory - 1;
+
+	//Which fields of a car changed since the base snapshot.
+	enum NetChange : uint8_t
+	{
+		ChangeX = 1, ChangeZ = 2, ChangeYaw = 4, ChangeGates = 8, ChangeHealth = 16, ChangeFlags = 32
+	};
+
+	//Little-endian writes into a packet.  Varints take 7 bits a byte; signed values are zigzagged
+	//first so small negative changes stay small.
+	class ByteWriter
+	{
+	public:
+		ByteWriter(uint8_t* data, int capacity) : data(data), capacity(capacity) {}
+
+		void U8(uint32_t value)
+		{
+			if (size < capacity)
+			{
+				data[size] = uint8_t(value);
+			}
+			size++;
+		}
+		void U16(uint32_t value) { U8(value); U8(value >> 8); }
+		void U32(uint32_t value) { U16(value); U16(value >> 16); }
+		void Varint(uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				U8(value | 0x80);
+				value >>= 7;
+			}
+			U8(value);
+		}
+		void Signed(int32_t value) { Varint(uint32_t(value) << 1 ^ uint32_t(value >> 31)); }
+
+		int Size() const { return size; }
+		bool Fits() const { return size <= capacity; }
+
+	private:
+		uint8_t* data;
+		int capacity;
+		int size = 0;
+	};
+
+	//Reads what ByteWriter wrote.  Reading past the end gives zeros and clears Ok().
+	class ByteReader
+	{
+	public:
+		ByteReader(const uint8_t* data, int size) : data(data), size(size) {}
+
+		uint32_t U8()
+		{
+			if (at >= size)
+			{
+				ok = false;
+				return 0;
+			}
+			return data[at++];
+		}
+		uint32_t U16() { uint32_t low = U8(); return low | U8() << 8; }
+		uint32_t U32() { uint32_t low = U16(); return low | U16() << 16; }
+		uint32_t Varint()
+		{
+			uint32_t value = 0;
+			for (int shift = 0; shift < 35; shift += 7)
+			{
+				uint32_t byte = U8();
+				value |= (byte & 0x7f) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+			ok = false;
+			return 0;
+		}
+		int32_t Signed()
+		{
+			uint32_t value = Varint();
+			return int32_t(value >> 1 ^ (0u - (value & 1)));
+		}
+
+		bool Ok() const { return ok; }
+
+	private:
+		const uint8_t* data;
+		int size;
+		int at = 0;
+		bool ok = true;
+	};
+
+	int32_t Quantise(float value, float scale)
+	{
+		return int32_t(std::lround(value * scale));
+	}
+
+	uint16_t QuantiseYaw(float yaw)
+	{
+		return uint16_t(uint32_t(Quantise(std::fmod(yaw, 360.0f), yawScale)));
+	}
+
+	NetCar MakeNetCar(const RaceSimulation& sim, int car)
+	{
+		int playerCount = sim.PlayerCount();
+		NetCar result;
+		result.car = uint32_t(car);
+		result.gates = uint16_t(sim.Laps().GatesPassed(car));
+		result.flags = sim.Laps().Finished(car) ? NetCarFinished : 0;
+		if (car < playerCount)
+		{
+			const CarState& player = sim.Player(car);
+			result.x = Quantise(player.x, positionScale);
+			result.z = Quantise(player.z, positionScale);
+			result.yaw = QuantiseYaw(player.yaw);
+			result.health = uint8_t(std::min(std::max(player.health, 0), 255));
+		}
+		else
+		{
+			int i = car - playerCount;
+			result.x = Quantise(sim.Ai().x[i], positionScale);
+			result.z = Quantise(sim.Ai().z[i], positionScale);
+			result.yaw = QuantiseYaw(sim.Ai().Yaw(i));
+			result.health = 0;
+			result.flags |= NetCarAi;
+		}
+		return result;
+	}
+
+	//Finds a slot by tick, or null if it has been written over since.
+	const NetSnapshot* FindSnapshot(const std::vector<NetSnapshot>& history, uint32_t tick)
+	{
+		const NetSnapshot& slot = history[tick & historyMask];
+		return tick != 0 && slot.tick == tick ? &slot : nullptr;
+	}
+
+	double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+bool RaceServer::Open(RaceSimulation& race, const NetAddress& local, std::string& error)
+{
+	if (race.PlayerCount() >= netNoPlayer)
+	{
+		error = "too many players for one server";
+		return false;
+	}
+	if (!socket.Open(local, error))
+	{
+		return false;
+	}
+	sim = &race;
+	clients.clear();
+	clients.reserve(race.PlayerCount());
+	inputs.assign(race.PlayerCount(), RaceInput());
+	tick = 0;
+	stats = NetServerStats();
+	return true;
+}
+
+void RaceServer::Poll()
+{
+	auto start = std::chrono::steady_clock::now();
+	uint8_t packet[netMaxPacket];
+	NetAddress from;
+	int size;
+	while ((size = socket.Receive(packet, sizeof(packet), from)) > 0)
+	{
+		stats.bytesReceived += size;
+		if (packet[0] == PacketJoin)
+		{
+			Join(from, packet, size);
+		}
+		else if (packet[0] == PacketInput)
+		{
+			TakeInput(from, packet, size);
+		}
+	}
+	stats.netSeconds += SecondsSince(start);
+}
+
+void RaceServer::Join(const NetAddress& from, const uint8_t* data, int size)
+{
+	ByteReader in(data, size);
+	in.U8();
+	uint32_t version = in.U8();
+	uint32_t checksum = in.U32();
+	if (!in.Ok())
+	{
+		return;
+	}
+
+	//A client whose welcome was lost asks again and gets the same car.
+	uint32_t trackChecksum = TrackChecksum(sim->Track());
+	int player = netNoPlayer;
+	for (const Client& client : clients)
+	{
+		player = client.address == from ? client.player : player;
+	}
+	if (player == netNoPlayer && version == netProtocolVersion && checksum == trackChecksum && ClientCount() < sim->PlayerCount())
+	{
+		Client client;
+		client.address = from;
+		client.player = ClientCount();
+		client.sent.resize(netHistory);
+		clients.push_back(client);
+		player = client.player;
+	}
+
+	uint8_t packet[16];
+	ByteWriter out(packet, sizeof(packet));
+	out.U8(PacketWelcome);
+	out.U8(uint32_t(player));
+	out.U16(uint32_t(std::lround(sim->Settings().tickRate)));
+	out.U32(uint32_t(sim->PlayerCount() + sim->Ai().Count()));
+	out.U32(trackChecksum);
+	socket.Send(from, packet, out.Size());
+	stats.bytesSent += out.Size();
+}
+
+void RaceServer::TakeInput(const NetAddress& from, const uint8_t* data, int size)
+{
+	ByteReader in(data, size);
+	in.U8();
+	uint32_t player = in.U8();
+	uint32_t count = in.U8();
+	uint32_t sequence = in.U32();
+	uint32_t ackTick = in.U32();
+	Client* sender = nullptr;
+	for (Client& client : clients)
+	{
+		sender = client.address == from && uint32_t(client.player) == player ? &client : sender;
+	}
+	if (sender == nullptr || count == 0 || count > netInputRedundancy || sequence < count)
+	{
+		return;
+	}
+
+	//Oldest first.  Held buttons come from the newest input, presses from every new one so a lost packet loses none.
+	RaceInput newest;
+	uint16_t presses = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		RaceInput input;
+		input.buttons = uint16_t(in.U16());
+		input.mouseMoveX = int16_t(in.U16());
+		input.mouseMoveY = int16_t(in.U16());
+		if (sequence - (count - 1 - i) > sender->inputSequence)
+		{
+			presses = uint16_t(presses | (input.buttons & pressButtons));
+			newest = input;
+		}
+	}
+	if (!in.Ok() || sequence <= sender->inputSequence)
+	{
+		return; //Broken, or older than what has already arrived.
+	}
+	sender->inputSequence = sequence;
+	sender->input = newest;
+	sender->input.buttons = uint16_t(newest.buttons & ~pressButtons);
+	sender->presses = uint16_t(sender->presses | presses);
+	if (ackTick > sender->ackTick && ackTick <= tick)
+	{
+		sender->ackTick = ackTick;
+	}
+}
+
+void RaceServer::Step()
+{
+	//Players nobody has joined as sit on the grid.
+	for (Client& client : clients)
+	{
+		RaceInput& input = inputs[client.player];
+		input = client.input;
+		input.buttons = uint16_t(input.buttons | client.presses);
+		client.presses = 0;
+	}
+
+	auto simStart = std::chrono::steady_clock::now();
+	sim->Step(inputs.data());
+	stats.simSeconds += SecondsSince(simStart);
+	tick++;
+	stats.ticks++;
+
+	auto netStart = std::chrono::steady_clock::now();
+	for (Client& client : clients)
+	{
+		SendSnapshot(client);
+	}
+	stats.netSeconds += SecondsSince(netStart);
+}
+
+void RaceServer::FindNearest(int car, NetSnapshot& snapshot)
+{
+	//Walk out both ways from the car along the simulation's z order, nearest gap first, until
+	//the gap alone is further than the furthest of the nearest cars found so far.
+	const std::vector<int>& order = sim->CarOrder();
+	const std::vector<float>& carX = sim->CarX();
+	const std::vector<float>& carZ = sim->CarZ();
+	int count = int(order.size());
+	float x = carX[car];
+	float z = carZ[car];
+	int at = int(std::lower_bound(order.begin(), order.end(), z, [&carZ](int a, float value) { return carZ[a] < value; }) - order.begin());
+
+	int nearest[netRelevantCars];
+	float nearestDistance[netRelevantCars]; //Squared, closest first.
+	int found = 0;
+	int below = at - 1;
+	int above = at;
+	while (below >= 0 || above < count)
+	{
+		float belowGap = below >= 0 ? z - carZ[order[below]] : std::numeric_limits<float>::infinity();
+		float aboveGap = above < count ? carZ[order[above]] - z : std::numeric_limits<float>::infinity();
+		float gap = std::min(belowGap, aboveGap);
+		if (found == netRelevantCars && gap * gap >= nearestDistance[found - 1])
+		{
+			break;
+		}
+		int other = belowGap < aboveGap ? order[below--] : order[above++];
+		if (other == car)
+		{
+			continue;
+		}
+		float dx = carX[other] - x;
+		float dz = carZ[other] - z;
+		float distance = dx * dx + dz * dz;
+		if (found == netRelevantCars && distance >= nearestDistance[found - 1])
+		{
+			continue;
+		}
+
+		//Insert in distance order, dropping the furthest when full.
+		int slot = found < netRelevantCars ? found++ : found - 1;
+		while (slot > 0 && nearestDistance[slot - 1] > distance)
+		{
+			nearest[slot] = nearest[slot - 1];
+			nearestDistance[slot] = nearestDistance[slot - 1];
+			slot--;
+		}
+		nearest[slot] = other;
+		nearestDistance[slot] = distance;
+	}
+
+	snapshot.count = 0;
+	snapshot.cars[snapshot.count++] = MakeNetCar(*sim, car);
+	for (int i = 0; i < found; i++)
+	{
+		snapshot.cars[snapshot.count++] = MakeNetCar(*sim, nearest[i]);
+	}
+	std::sort(snapshot.cars, snapshot.cars + snapshot.count, [](const NetCar& a, const NetCar& b) { return a.car < b.car; });
+}
+
+void RaceServer::SendSnapshot(Client& client)
+{
+	NetSnapshot& snapshot = client.sent[tick & historyMask];
+	snapshot.tick = tick;
+	FindNearest(client.player, snapshot);
+
+	//Changes are taken against the newest snapshot the client says it has, or against nothing.
+	const NetSnapshot* base = client.ackTick < tick && tick - client.ackTick < netHistory ? FindSnapshot(client.sent, client.ackTick) : nullptr;
+
+	uint8_t packet[netMaxPacket];
+	ByteWriter out(packet, sizeof(packet));
+	out.U8(PacketSnapshot);
+	out.U8(uint32_t(client.player));
+	out.U32(tick);
+	out.U32(base != nullptr ? base->tick : 0);
+
+	//The rest of the client's own car, whole.
+	const CarState& player = sim->Player(client.player);
+	out.U8(sim->State());
+	out.Varint(client.inputSequence);
+	out.Signed(Quantise(player.momentum.x, momentumScale));
+	out.Signed(Quantise(player.momentum.z, momentumScale));
+	out.Varint(uint32_t(std::max(Quantise(player.boostDuration, timeScale), 0)));
+	out.Varint(uint32_t(std::max(Quantise(player.overheatDuration, timeScale), 0)));
+	out.Signed(player.health);
+	out.Varint(uint32_t(sim->NextCheckpoint(client.player)));
+	out.Varint(uint32_t(std::max(Quantise(sim->CountDownLeft(), timeScale), 0)));
+	out.Varint(uint32_t(Quantise(sim->RaceTime(), timeScale)));
+
+	//Each car as the gap from the last car number, then a mask of what changed, then the changes.
+	out.U8(uint32_t(snapshot.count));
+	int baseAt = 0;
+	uint32_t lastCar = 0;
+	for (int i = 0; i < snapshot.count; i++)
+	{
+		const NetCar& car = snapshot.cars[i];
+		NetCar was = {};
+		while (base != nullptr && baseAt < base->count && base->cars[baseAt].car < car.car)
+		{
+			baseAt++;
+		}
+		if (base != nullptr && baseAt < base->count && base->cars[baseAt].car == car.car)
+		{
+			was = base->cars[baseAt];
+		}
+
+		uint32_t changed = (car.x != was.x ? ChangeX : 0) | (car.z != was.z ? ChangeZ : 0) | (car.yaw != was.yaw ? ChangeYaw : 0) |
+			(car.gates != was.gates ? ChangeGates : 0) | (car.health != was.health ? ChangeHealth : 0) | (car.flags != was.flags ? ChangeFlags : 0);
+		out.Varint(car.car - lastCar);
+		lastCar = car.car;
+		out.U8(changed);
+		if (changed & ChangeX)
+		{
+			out.Signed(car.x - was.x);
+		}
+		if (changed & ChangeZ)
+		{
+			out.Signed(car.z - was.z);
+		}
+		if (changed & ChangeYaw)
+		{
+			out.Signed(int16_t(uint16_t(car.yaw - was.yaw)));
+		}
+		if (changed & ChangeGates)
+		{
+			out.Signed(int32_t(car.gates) - int32_t(was.gates));
+		}
+		if (changed & ChangeHealth)
+		{
+			out.U8(car.health);
+		}
+		if (changed & ChangeFlags)
+		{
+			out.U8(car.flags);
+		}
+	}
+
+	if (out.Fits())
+	{
+		socket.Send(client.address, packet, out.Size());
+		stats.bytesSent += out.Size();
+		stats.snapshots++;
+	}
+}
+
+bool RaceClient::Join(const NetAddress& address, uint32_t checksum, std::string& error)
+{
+	if (!socket.IsOpen() && !socket.Open(NetAddress(), error))
+	{
+		return false;
+	}
+	server = address;
+	trackChecksum = checksum;
+
+	uint8_t packet[8];
+	ByteWriter out(packet, sizeof(packet));
+	out.U8(PacketJoin);
+	out.U8(netProtocolVersion);
+	out.U32(checksum);
+	if (!socket.Send(server, packet, out.Size()))
+	{
+		error = "cannot reach the server";
+		return false;
+	}
+	bytesSent += out.Size();
+	return true;
+}
+
+void RaceClient::SendInput(const RaceInput& input)
+{
+	if (!Connected())
+	{
+		return;
+	}
+	std::copy(recent + 1, recent + netInputRedundancy, recent);
+	recent[netInputRedundancy - 1] = input;
+	sequence++;
+	uint32_t count = std::min(sequence, uint32_t(netInputRedundancy));
+
+	uint8_t packet[16 + netInputRedundancy * 6];
+	ByteWriter out(packet, sizeof(packet));
+	out.U8(PacketInput);
+	out.U8(uint32_t(player));
+	out.U8(count);
+	out.U32(sequence);
+	out.U32(latestTick); //Acknowledges the newest snapshot, to take the next one's changes against.
+	for (uint32_t i = netInputRedundancy - count; i < netInputRedundancy; i++)
+	{
+		out.U16(recent[i].buttons);
+		out.U16(uint16_t(recent[i].mouseMoveX));
+		out.U16(uint16_t(recent[i].mouseMoveY));
+	}
+	socket.Send(server, packet, out.Size());
+	bytesSent += out.Size();
+}
+
+int RaceClient::Receive()
+{
+	int snapshots = 0;
+	uint8_t packet[netMaxPacket];
+	NetAddress from;
+	int size;
+	while ((size = socket.Receive(packet, sizeof(packet), from)) > 0)
+	{
+		if (from != server)
+		{
+			continue;
+		}
+		bytesReceived += size;
+		if (packet[0] == PacketWelcome && !Connected())
+		{
+			ByteReader in(packet, size);
+			in.U8();
+			uint32_t slot = in.U8();
+			in.U16();
+			uint32_t carCount = in.U32();
+			uint32_t checksum = in.U32();
+			if (!in.Ok())
+			{
+				continue;
+			}
+			if (slot == netNoPlayer || checksum != trackChecksum)
+			{
+				refused = true;
+				continue;
+			}
+			player = int(slot);
+			cars.assign(carCount, NetCarView());
+			received.assign(netHistory, NetSnapshot());
+		}
+		else if (packet[0] == PacketSnapshot && Connected() && ReadSnapshot(packet, size))
+		{
+			snapshots++;
+		}
+	}
+	return snapshots;
+}
+
+bool RaceClient::ReadSnapshot(const uint8_t* data, int size)
+{
+	ByteReader in(data, size);
+	in.U8();
+	in.U8();
+	uint32_t tick = in.U32();
+	uint32_t baseTick = in.U32();
+	const NetSnapshot* base = FindSnapshot(received, baseTick);
+	if (tick <= latestTick || (baseTick != 0 && base == nullptr))
+	{
+		return false; //Late, or its base has gone.
+	}
+
+	NetOwnState next;
+	next.state = RaceState(in.U8());
+	next.inputSequence = in.Varint();
+	next.momentumX = in.Signed() / momentumScale;
+	next.momentumZ = in.Signed() / momentumScale;
+	next.boostDuration = in.Varint() / timeScale;
+	next.overheatDuration = in.Varint() / timeScale;
+	next.health = in.Signed();
+	next.nextCheckpoint = int(in.Varint());
+	next.countDown = in.Varint() / timeScale;
+	next.raceTime = in.Varint() / timeScale;
+
+	NetSnapshot snapshot;
+	snapshot.tick = tick;
+	snapshot.count = int(in.U8());
+	if (snapshot.count > netRelevantCars + 1)
+	{
+		return false;
+	}
+	int baseAt = 0;
+	uint32_t lastCar = 0;
+	for (int i = 0; i < snapshot.count; i++)
+	{
+		NetCar& car = snapshot.cars[i];
+		car = {};
+		car.car = lastCar + in.Varint();
+		lastCar = car.car;
+		while (base != nullptr && baseAt < base->count && base->cars[baseAt].car < car.car)
+		{
+			baseAt++;
+		}
+		if (base != nullptr && baseAt < base->count && base->cars[baseAt].car == car.car)
+		{
+			car = base->cars[baseAt];
+		}
+
+		uint32_t changed = in.U8();
+		car.x += changed & ChangeX ? in.Signed() : 0;
+		car.z += changed & ChangeZ ? in.Signed() : 0;
+		car.yaw = uint16_t(car.yaw + (changed & ChangeYaw ? in.Signed() : 0));
+		car.gates = uint16_t(car.gates + (changed & ChangeGates ? in.Signed() : 0));
+		car.health = changed & ChangeHealth ? uint8_t(in.U8()) : car.health;
+		car.flags = changed & ChangeFlags ? uint8_t(in.U8()) : car.flags;
+		if (car.car >= cars.size())
+		{
+			return false;
+		}
+	}
+	if (!in.Ok())
+	{
+		return false;
+	}
+
+	received[tick & historyMask] = snapshot;
+	latestTick = tick;
+	own = next;
+	for (int i = 0; i < snapshot.count; i++)
+	{
+		const NetCar& car = snapshot.cars[i];
+		NetCarView& view = cars[car.car];
+		view.x = car.x / positionScale;
+		view.z = car.z / positionScale;
+		view.yaw = car.yaw / yawScale;
+		view.gates = car.gates;
+		view.health = car.health;
+		view.flags = car.flags;
+		view.tick = tick;
+	}
+	return true;
+}
+
+CarState RaceClient::OwnCar() const
+{
+	CarState car = {};
+	if (Connected())
+	{
+		const NetCarView& view = cars[player];
+		car.x = view.x;
+		car.z = view.z;
+		car.yaw = view.yaw;
+	}
+	car.momentum = { own.momentumX, own.momentumZ };
+	car.health = own.health;
+	car.boostDuration = own.boostDuration;
+	car.overheatDuration = own.overheatDuration;
+	return car;
+}
@@ -0,0 +1,167 @@
+// Jonathan Walsh
+//Networked races.  The server owns the one RaceSimulation and runs it; each client sends the
+//input for its car every tick and gets back a snapshot of the race as the server sees it.
+//
+//Snapshots are quantised (positions to a sixteenth of a unit, yaw to a 65536th of a turn) and
+//sent as changes against the last snapshot that client acknowledged, so cars that did not move
+//cost two bytes.  Each client only hears about its own car and the netRelevantCars cars nearest
+//it, found from the simulation's sorted car list, so a snapshot stays the same size however many
+//cars are racing.
+#pragma once
+#include "NetSocket.h"
+#include "RaceSimulation.h"
+#include <string>
+#include <vector>
+
+const uint16_t defaultRacePort = 27960;
+const uint8_t netProtocolVersion = 1;
+const int netRelevantCars = 24; //Other cars in each snapshot.
+const int netHistory = 32; //Snapshots each side keeps to take changes against, a power of two.
+const int netInputRedundancy = 4; //Each input packet repeats the last few inputs in case one was lost.
+const int netMaxPacket = 1200; //Stays under the usual MTU.
+const uint8_t netNoPlayer = 255; //Sent in the welcome when the server is full.
+
+enum NetPacketType : uint8_t
+{
+	PacketJoin = 1, PacketWelcome, PacketInput, PacketSnapshot
+};
+
+//Flags on a car in a snapshot.
+enum NetCarFlag : uint8_t
+{
+	NetCarAi = 1,
+	NetCarFinished = 2
+};
+
+//One car as it goes over the wire.
+struct NetCar
+{
+	uint32_t car; //Numbered the same as the laps: the players, then the AI cars.
+	int32_t x; //Sixteenths of a unit.
+	int32_t z;
+	uint16_t yaw; //65536ths of a turn.
+	uint16_t gates; //Checkpoints passed.
+	uint8_t health;
+	uint8_t flags; //NetCarFlag bits.
+};
+
+//The cars one snapshot held, sorted by car, kept by both ends to take the next changes against.
+struct NetSnapshot
+{
+	uint32_t tick = 0; //0 is an empty slot.
+	int count = 0;
+	NetCar cars[netRelevantCars + 1];
+};
+
+//The rest of the client's own car and the race, sent whole in every snapshot.
+struct NetOwnState
+{
+	float momentumX = 0.0f;
+	float momentumZ = 0.0f;
+	float boostDuration = 0.0f;
+	float overheatDuration = 0.0f;
+	int health = 0;
+	int nextCheckpoint = 0;
+	RaceState state = StateWaiting;
+	float countDown = 0.0f;
+	float raceTime = 0.0f;
+	uint32_t inputSequence = 0; //The newest input the server had used.
+};
+
+//A car as the client last heard of it.
+struct NetCarView
+{
+	float x = 0.0f;
+	float z = 0.0f;
+	float yaw = 0.0f; //Degrees.
+	int gates = 0;
+	int health = 0;
+	uint8_t flags = 0;
+	uint32_t tick = 0; //Snapshot it was last in, 0 for never.
+};
+
+struct NetServerStats
+{
+	long long ticks = 0;
+	long long snapshots = 0;
+	long long bytesSent = 0;
+	long long bytesReceived = 0;
+	double simSeconds = 0.0; //Time in RaceSimulation::Step.
+	double netSeconds = 0.0; //Time reading input and building and sending snapshots.
+};
+
+class RaceServer
+{
+public:
+	//The simulation's PlayerCount() is how many clients can join.  Port 0 picks any free port.
+	bool Open(RaceSimulation& sim, const NetAddress& local, std::string& error);
+	void Poll(); //Takes every waiting join and input.
+	void Step(); //Runs one tick on each player's newest input and sends every client a snapshot.
+
+	uint16_t Port() const { return socket.Port(); }
+	int ClientCount() const { return int(clients.size()); }
+	uint32_t Tick() const { return tick; }
+	const NetServerStats& Stats() const { return stats; }
+
+private:
+	struct Client
+	{
+		NetAddress address;
+		int player;
+		uint32_t inputSequence = 0; //Newest input received.
+		uint32_t ackTick = 0; //Newest snapshot the client has.
+		RaceInput input; //Newest input, without presses.
+		uint16_t presses = 0; //Presses since the last tick.
+		std::vector<NetSnapshot> sent; //netHistory slots, by tick.
+	};
+
+	void Join(const NetAddress& from, const uint8_t* data, int size);
+	void TakeInput(const NetAddress& from, const uint8_t* data, int size);
+	void FindNearest(int car, NetSnapshot& snapshot);
+	void SendSnapshot(Client& client);
+
+	RaceSimulation* sim = nullptr;
+	UdpSocket socket;
+	std::vector<Client> clients;
+	std::vector<RaceInput> inputs; //One per player.
+	uint32_t tick = 0;
+	NetServerStats stats;
+};
+
+class RaceClient
+{
+public:
+	//Asks to join; Connected() is true once Receive has had the welcome.  Send it again if no answer comes.
+	bool Join(const NetAddress& server, uint32_t trackChecksum, std::string& error);
+	bool Connected() const { return player >= 0; }
+	bool Refused() const { return refused; } //The server was full or has a different track.
+
+	void SendInput(const RaceInput& input);
+	int Receive(); //Reads every waiting packet and returns how many new snapshots there were.
+
+	int Player() const { return player; }
+	int CarCount() const { return int(cars.size()); }
+	uint32_t Tick() const { return latestTick; } //The server tick of the newest snapshot.
+	const NetCarView& Car(int car) const { return cars[car]; }
+	const NetOwnState& Own() const { return own; }
+	CarState OwnCar() const; //The client's car as the simulation would hold it, as far as the snapshots tell.
+	long long BytesSent() const { return bytesSent; }
+	long long BytesReceived() const { return bytesReceived; }
+
+private:
+	bool ReadSnapshot(const uint8_t* data, int size);
+
+	UdpSocket socket;
+	NetAddress server;
+	uint32_t trackChecksum = 0;
+	int player = -1;
+	bool refused = false;
+	uint32_t sequence = 0;
+	RaceInput recent[netInputRedundancy]; //The last inputs sent, oldest first.
+	std::vector<NetSnapshot> received; //netHistory slots, by tick.
+	uint32_t latestTick = 0;
+	std::vector<NetCarView> cars;
+	NetOwnState own;
+	long long bytesSent = 0;
+	long long bytesReceived = 0;
+};
@@ -0,0 +1,94 @@
+// Jonathan Walsh
+#include "RacePhysics.h"
+#include <cmath>
+
+vector2D Scalar(float s, vector2D v)
+{
+	return { s* v.x, s* v.z }; //Scales vectors up.
+}
+
+vector2D Sum3(vector2D v1, vector2D v2, vector2D v3)
+{
+	return { v1.x + v2.x + v3.x, v1.z + v2.z + v3.z }; //Adds all three force vectors up.
+}
+
+bool CheckpointPassed(float carPointX, float carPointZ, float checkpointX, float checkpointZ, float checkpointW, float checkpointD)
+{
+	float minX = checkpointX - checkpointW / 2;
+	float maxX = checkpointX + checkpointW / 2;
+	float minZ = checkpointZ - checkpointD / 2;
+	float maxZ = checkpointZ + checkpointD / 2;
+
+	return(carPointX > minX && carPointX < maxX && carPointZ > minZ && carPointZ < maxZ); //Returns true when all statements are true
+																						  //When the point(hovercar) is inside the sphere(checkpoint) the statement becomes true.
+}
+
+boxSide car2Box(float carXPos, float carZPos, float oldCarXPos, float oldCarZPos, float carRad,
+	float boxXPos, float boxZPos, float boxWidth, float boxDepth)
+{
+	float minX = boxXPos - boxWidth / 2 - carRad;
+	float maxX = boxXPos + boxWidth / 2 + carRad;
+	float minZ = boxZPos - boxDepth / 2 - carRad;
+	float maxZ = boxZPos + boxDepth / 2 + carRad;
+
+	boxSide result = NoSide; //If no blocks have been hit, then no side is the result.
+
+	if (carXPos > minX && carXPos < maxX && carZPos > minZ && carZPos < maxZ) //A block has been hit.
+	{
+		//Works out which side has been hit.
+		if (oldCarXPos < minX)
+		{
+			result = LeftSide;
+		}
+		else if (oldCarXPos > maxX)
+		{
+			result = RightSide;
+		}
+		else if (oldCarZPos < minZ)
+		{
+			result = FrontSide;
+		}
+		else if (oldCarZPos > maxZ)
+		{
+			result = BackSide;
+		}
+	}
+	return(result); //Returns the side which has been hit to the main code, when method has been called.
+}
+bool car2Sphere(float carXPos, float carZPos, float carRad, float strutXPos, float strutZPos, float strutRad)
+{
+	float distX = carXPos - strutXPos;
+	float distZ = carZPos - strutZPos;
+	float dist = sqrt(distX*distX + distZ * distZ); //The current distance between the car and the strut.
+
+													//Returns true if both the radii added together are greater than the 
+													//current distance between the car and the strut, hence a collision is detected.
+	return (dist < (carRad + strutRad));
+}
+
+int CarDamage(float speed, int health)
+{
+	float minimumDamSpeed = 10.0f;
+	float firstTierLimit = 50.0f;
+	float secondTierLimit = 120.0f;
+	int firstTierDeduct = 1;
+	int secondTierDeduct = 2;
+	int thirdTierDeduct = 5;
+
+	if (speed > minimumDamSpeed && speed < firstTierLimit)
+	{
+		return health - firstTierDeduct; //Low impact.
+	}
+	else if (speed > firstTierDeduct && speed < secondTierLimit)
+	{
+		return health - secondTierDeduct; //Medium impact.
+	}
+	else if (speed > secondTierLimit)
+	{
+		return health - thirdTierDeduct; //High impact.
+	}
+	else
+	{
+		return health - 0; //No or very minor impact.
+	}
+}
@@ -0,0 +1,36 @@
+// Jonathan Walsh
+//Physics and collision primitives shared by the game and the headless simulation.
+//Nothing in here depends on the TL-Engine, so it builds on any platform.
+#pragma once
+
+struct vector2D
+{
+	//X and Z coordinates for momentumm, thrust and drag.
+	float x;
+	float z;
+};
+enum boxSide { LeftSide, RightSide, FrontSide, BackSide, NoSide }; //Shows side that box is collided with during collision.
+
+//Checkpoint dimensions.
+constexpr float checkpointWidth = 20.0f;
+constexpr float checkpointDepth = 3.0f;
+
+//Width and depth of each wall.
+constexpr float wallWidth = 2.0f;
+constexpr float wallDepth = 10.0f;
+
+//Radii for each model.  Compile-time constants, so CompiledTrack.h can grow obstacles by the car's radius.
+constexpr float carRad = 4.0f;
+constexpr float strutRad = 0.1f;
+constexpr float tankRad = 0.5f;
+
+const float maxDistance = 1000.0f; //Cars further than this from the origin have left the course.
+const float courseMargin = 200.0f; //How far past the furthest gate or waypoint a car can go on bigger tracks.
+
+vector2D Scalar(float s, vector2D v); //Scalar to created when a 2D vector is multiplied by a multiplier.
+vector2D Sum3(vector2D v1, vector2D v2, vector2D v3); //Adds the momentum, thrust and drag together.
+bool CheckpointPassed(float carPointX, float carPointZ, float checkpointX, float checkpointZ, float checkpointW, float checkpointD); //Point-sphere collision detection with checkpoints.
+boxSide car2Box(float carXPos, float carZPos, float oldCarXPos, float oldCarZPos, float carRad,
+	float boxXPos, float boxZPos, float boxWidth, float boxDepth); //Sphere-box collision detection.
+bool car2Sphere(float carXPos, float carZPos, float carRad, float strutXPos, float strutZPos, float strutRad); //Sphre-sphere collision detection.
+int CarDamage(float speed, int health); //Damage model for when car collides with objects.
@@ -0,0 +1,711 @@
+// Jonathan Walsh
+#include "RaceSimulation.h"
+#include "SweptCollision.h"
+#include "FrameProfiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const float degreesToRadians = 3.14159265f / 180.0f;
+	const float radiansToDegrees = 180.0f / 3.14159265f;
+
+	//Moves longer than this in one frame could skip over a strut or wall, so they are swept.
+	const float sweepDistance = carRad;
+	const float sweepBackOff = 0.01f; //Stops just short of the contact point so the car is not left touching.
+
+	const int contactPasses = 4; //Times round a car's contacts when pushing it out.
+	const float impactSpeed = 1.0f; //Slower than this into something is a scrape, not a hit.
+	const int contactsReserved = 64; //Per player, so a normal tick never allocates.
+
+	//Cars per job when the work is split across the pool.  Fewer cars than two jobs' worth run on one thread.
+	const int aiJobCars = 2048;
+	const int sweepJobCars = 4096;
+
+	int JobCount(int count, int perJob)
+	{
+		return count < perJob * 2 ? 1 : (count + perJob - 1) / perJob;
+	}
+
+	//Local Z of a model rotated around Y, the same as row 2 of its TL-Engine matrix.
+	vector2D FacingVector(float yaw)
+	{
+		return { std::sin(yaw * degreesToRadians), std::cos(yaw * degreesToRadians) };
+	}
+}
+
+RaceSimulation::RaceSimulation(const TrackData& track, const RaceSettings& settings)
+	: track(track), settings(settings), countDown(settings.countDown)
+{
+	//The boost grows thrust by 1.0001 and overheating grows drag by 1.001 every 60th of a second.
+	tickTime = 1.0f / std::max(settings.tickRate, 1.0f);
+	tickScale = referenceTickRate / std::max(settings.tickRate, 1.0f);
+	thrustChange = std::pow(1.0001f, tickScale);
+	changeDrag = std::pow(1.001f, tickScale);
+
+	CarState player;
+	player.x = 0.0f;
+	player.z = settings.initialCarZPos;
+	player.yaw = 0.0f;
+	player.momentum = { 0.0f, 0.0f };
+	player.thrust = { 0.0f, 0.0f };
+	player.drag = { 0.0f, 0.0f };
+	player.thrustMultiplier = settings.defaultThrust;
+	player.dragCoeff = settings.defaultDrag;
+	player.health = settings.health;
+	player.boostDuration = settings.defaultBoost;
+	player.overheatDuration = settings.defaultBoost;
+	player.speed = 0.0f;
+	player.damageTaken = 0;
+	player.collisions = 0;
+	for (int p = 0; p < std::max(settings.playerCount, 1); p++)
+	{
+		player.x = -p * settings.aiGridSpacing;
+		players.push_back(player);
+		previousPlayers.push_back({ player.x, player.z, player.yaw });
+	}
+	int playerCount = PlayerCount();
+	playerOldX.resize(playerCount);
+	playerOldZ.resize(playerCount);
+	playerMomentum.resize(playerCount);
+	tickInputs.resize(playerCount);
+
+	for (int i = 0; i < settings.aiCarCount; i++)
+	{
+		int column = i % std::max(settings.aiGridColumns, 1);
+		int row = i / std::max(settings.aiGridColumns, 1);
+		ai.Add(settings.initialAiXPos + column * settings.aiGridSpacing, settings.initialCarZPos - row * settings.aiGridSpacing);
+	}
+
+	gates.Build(track.checkpointX, track.checkpointZ, track.checkpointRotation, checkpointWidth);
+
+	//Big generated tracks reach past the original course, so the limit grows to fit the gates and waypoints.
+	float furthest = 0.0f;
+	for (int i = 0; i < track.checkpointX.count; i++)
+	{
+		furthest = std::max(furthest, std::sqrt(track.checkpointX[i] * track.checkpointX[i] + track.checkpointZ[i] * track.checkpointZ[i]));
+	}
+	for (int i = 0; i < track.waypointX.count; i++)
+	{
+		furthest = std::max(furthest, std::sqrt(track.waypointX[i] * track.waypointX[i] + track.waypointZ[i] * track.waypointZ[i]));
+	}
+	courseRadius = std::max(maxDistance, furthest + courseMargin);
+	laps.Reset(playerCount + ai.Count(), gates.Count(), settings.laps);
+	aiOldX = ai.x;
+	aiOldZ = ai.z;
+	aiOldHeadingX = ai.headingX;
+	aiOldHeadingZ = ai.headingZ;
+
+	int carCount = playerCount + ai.Count();
+	carSweep.Resize(carCount);
+	carX.resize(carCount);
+	carZ.resize(carCount);
+	carPairs.reserve(carCount * 2);
+
+	//Big enough for every obstacle to be hit at once, so the kernels never need to allocate.
+	int mostObstacles = std::max(track.walls.count, std::max(track.struts.count, track.tanks.count));
+	hitScratch.resize(mostObstacles);
+	sideScratch.resize(mostObstacles);
+	contacts.resize(playerCount);
+	for (std::vector<Contact>& found : contacts)
+	{
+		found.reserve(contactsReserved);
+	}
+}
+
+void RaceSimulation::SetWorkers(ThreadPool* pool)
+{
+	workers = pool;
+	if (workers != nullptr)
+	{
+		//Room for a few pairs per car, so the jobs do not allocate once the race is running.
+		jobPairs.resize(JobCount(int(carX.size()), sweepJobCars));
+		for (std::vector<CarPair>& pairs : jobPairs)
+		{
+			pairs.reserve(sweepJobCars * 2);
+		}
+	}
+}
+
+int RaceSimulation::Advance(const RaceInput& input, float frameTime)
+{
+	return Advance(input, frameTime, [] {});
+}
+
+void RaceSimulation::Step(const RaceInput& input)
+{
+	tickInputs[0] = input;
+	Step(tickInputs.data());
+}
+
+void RaceSimulation::Step(const RaceInput* inputs)
+{
+	int playerCount = PlayerCount();
+
+	//Where everything was at the start of the tick, for drawing between ticks.
+	for (int p = 0; p < playerCount; p++)
+	{
+		previousPlayers[p] = { players[p].x, players[p].z, players[p].yaw };
+		playerOldX[p] = players[p].x; //Reset position for hover car for when collides with objects.
+		playerOldZ[p] = players[p].z;
+	}
+	std::copy(ai.x.begin(), ai.x.end(), aiOldX.begin());
+	std::copy(ai.z.begin(), ai.z.end(), aiOldZ.begin());
+	std::copy(ai.headingX.begin(), ai.headingX.end(), aiOldHeadingX.begin());
+	std::copy(ai.headingZ.begin(), ai.headingZ.end(), aiOldHeadingZ.begin());
+
+	if ((sqrt(playerOldX[0] * playerOldX[0] + playerOldZ[0] * playerOldZ[0]) > courseRadius))
+	{
+		outOfBounds = true;//Game closes if you leave the course.
+	}
+
+	for (int p = 0; p < playerCount; p++)
+	{
+		CarState& player = players[p];
+		UpdatePlayer(player, inputs[p]);
+
+		//Convert momentum into scalar.
+		playerMomentum[p] = sqrt(player.momentum.x*player.momentum.x + player.momentum.z*player.momentum.z);
+	}
+
+	UpdateCountDown(inputs);
+	for (int p = 0; p < playerCount; p++)
+	{
+		UpdateCheckpoints(p, playerOldX[p], playerOldZ[p]);
+		FindContacts(p);
+	}
+
+	//Check for collision between cars
+	{
+		PROFILE_SCOPE(PhaseCarCollision);
+		ResolveCarHits();
+	}
+
+	//Every touch found this tick, resolved together.
+	for (int p = 0; p < playerCount; p++)
+	{
+		ResolveContacts(players[p], contacts[p], playerMomentum[p]);
+	}
+
+	for (int p = 0; p < playerCount; p++)
+	{
+		CarState& player = players[p];
+		UpdateBoost(player, inputs[p]);
+
+		//When health runs out a small amount of health is given
+		//back after drag has increased for a period of time.
+		//Refer to UpdateBoost where boost <= 0 for more details.^^^
+		if (player.health <= 0)
+		{
+			int damageHealth = 10;
+			player.boostDuration = 1.0f;
+			player.health = damageHealth;
+		}
+	}
+
+	UpdateAi();
+
+	if (gameStarted && !Finished())
+	{
+		raceTime += tickTime;
+	}
+	frameCount++;
+}
+
+bool RaceSimulation::Finished() const
+{
+	for (int p = 0; p < PlayerCount(); p++)
+	{
+		if (!laps.Finished(p))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+CarPose RaceSimulation::PlayerPose(int p) const
+{
+	float t = Interpolation();
+	const CarState& player = players[p];
+	const CarPose& previous = previousPlayers[p];
+	return { previous.x + (player.x - previous.x) * t, previous.z + (player.z - previous.z) * t,
+		previous.yaw + (player.yaw - previous.yaw) * t };
+}
+
+CarPose RaceSimulation::AiPose(int car) const
+{
+	float t = Interpolation();
+	//The AI's yaw comes from its heading, so it jumps from 180 to -180; turn the short way round.
+	float oldYaw = std::atan2(aiOldHeadingX[car], aiOldHeadingZ[car]) * radiansToDegrees;
+	float turn = ai.Yaw(car) - oldYaw;
+	if (turn > 180.0f)
+	{
+		turn -= 360.0f;
+	}
+	else if (turn < -180.0f)
+	{
+		turn += 360.0f;
+	}
+	return { aiOldX[car] + (ai.x[car] - aiOldX[car]) * t, aiOldZ[car] + (ai.z[car] - aiOldZ[car]) * t, oldYaw + turn * t };
+}
+
+void RaceSimulation::UpdatePlayer(CarState& player, const RaceInput& input)
+{
+	PROFILE_SCOPE(PhasePhysics);
+	//get the facing vector - local z of car
+	vector2D facingVector = FacingVector(player.yaw);
+
+	//THRUST AND STEERING ONLY WORK WHEN GAMESTARTED IS TRUE.
+	//calculate thrust(based on keyboard input)
+	if (input.Held(AccelForward) && gameStarted)
+	{
+		player.thrust = Scalar(player.thrustMultiplier, facingVector);
+	}
+	else if (input.Held(DecelBackward) && gameStarted)
+	{
+		player.thrust = Scalar(-player.thrustMultiplier, facingVector);
+	}
+	else
+	{
+		player.thrust = { 0.0f, 0.0f }; //No thrust when no keys are pressed, but still momentum.
+	}
+
+	//Steering
+	if (input.Held(SteerRight) && gameStarted)
+	{
+		player.yaw += settings.steeringFactor * tickTime;
+	}
+	if (input.Held(SteerLeft) && gameStarted)
+	{
+		player.yaw -= settings.steeringFactor * tickTime;
+	}
+
+	//calculate drag(based on previous momentum)
+	player.drag = Scalar(player.dragCoeff, player.momentum);
+
+	//caluclate momentum(based on thrust, drag and previous momentum)
+	//Thrust and drag are tuned per 60th of a second, so they are scaled to the length of the tick.
+	player.momentum = Sum3(player.momentum, Scalar(tickScale, player.thrust), Scalar(tickScale, player.drag));
+
+	//move the hover car (according to new momentum)
+	player.x += player.momentum.x * tickTime;
+	player.z += player.momentum.z * tickTime;
+
+	//Converts vector to scalar.  Speed is always positive, and shown as distance per 60th of a second.
+	float speed = sqrt(player.momentum.x*player.momentum.x + player.momentum.z*player.momentum.z) / referenceTickRate;
+	player.speed = speed * settings.realisticSpeed; //Gives a more realistic value for the speed.
+}
+
+void RaceSimulation::UpdateCountDown(const RaceInput* inputs)
+{
+	if (!countingDown)
+	{
+		for (int p = 0; p < PlayerCount(); p++)
+		{
+			if (inputs[p].Held(StartHit))
+			{
+				countingDown = true; //When space is pressed, count down starts.
+			}
+		}
+		return;
+	}
+
+	countDown -= tickTime; //The tick time is taken away from the countdown.
+
+	//The game counts down depending on the values of countdown when frametime is taken
+	//off countdown each frame.  When countdown is below 3.0, 3 is played and so on.
+	//When it reaches 0, the screen displays "Go".  Game started then becomes true
+	//and you can move the hover car.
+	if (laps.GatesPassed(0) == 0)
+	{
+		if (countDown < 3.0f)
+		{
+			status = { "3", -1, "" };
+			if (countDown <= 2.0f)
+			{
+				status = { "2", -1, "" };
+				if (countDown <= 1.0f)
+				{
+					status = { "1", -1, "" };
+					if (countDown <= 0.0f)
+					{
+						status = { "Go!", -1, "" };
+						gameStarted = true;
+					}
+				}
+			}
+		}
+	}
+}
+
+void RaceSimulation::UpdateCheckpoints(int car, float oldX, float oldZ)
+{
+	PROFILE_SCOPE(PhaseCheckpoints);
+	//Only the next checkpoint in order is tested.  Replaces countdown text with the stage the first player reached.
+	if (!laps.Update(gates, car, oldX, oldZ, players[car].x, players[car].z, raceTime) || car != 0)
+	{
+		return;
+	}
+	int passed = laps.GatesPassed(0);
+	if (laps.Finished(0))
+	{
+		status = { "Race Finished!", -1, "" };
+	}
+	else if (laps.NextGate(0) == 0)
+	{
+		status = { "Lap ", laps.Lap(0), " Complete" };
+	}
+	else
+	{
+		status = { "Stage ", passed - laps.Lap(0) * laps.Gates(), " Complete" };
+	}
+}
+
+void RaceSimulation::TakeDamage(CarState& player, float scalarMomentum)
+{
+	int oldHealth = player.health;
+	player.health = CarDamage(scalarMomentum, player.health); //Car gets damage when it hits the object.
+	player.damageTaken += oldHealth - player.health;
+	player.collisions++;
+}
+
+void RaceSimulation::FindSphereContacts(const CarState& player, const SphereObstacleView& spheres, const GridView& grid, std::vector<Contact>& found)
+{
+	//Only the obstacles in the grid cells under the car are tested.
+	int hitCount = 0;
+	grid.ForEachRange(player.x, player.z, carRad, [&](GridRange range)
+	{
+		hitCount += FindSphereHits(spheres, range.begin, range.end, player.x, player.z, hitScratch.data() + hitCount);
+	});
+	for (int h = 0; h < hitCount; h++)
+	{
+		//Out along the line from the centre of the obstacle to the centre of the car.
+		int i = hitScratch[h];
+		float dx = player.x - spheres.x[i];
+		float dz = player.z - spheres.z[i];
+		float distance = sqrt(dx*dx + dz * dz);
+		Contact contact;
+		contact.normalX = distance > 0.0f ? dx / distance : 0.0f;
+		contact.normalZ = distance > 0.0f ? dz / distance : -1.0f;
+		contact.depth = carRad + spheres.radius[i] - distance;
+		contact.slide = false;
+		found.push_back(contact);
+	}
+}
+
+void RaceSimulation::SweepStaticObstacles(CarState& player, float oldX, float oldZ, std::vector<Contact>& found)
+{
+	PROFILE_SCOPE(PhaseSweep);
+	float moveX = player.x - oldX;
+	float moveZ = player.z - oldZ;
+	float moveLength = sqrt(moveX*moveX + moveZ * moveZ);
+	if (moveLength <= sweepDistance)
+	{
+		return; //Short moves are caught by the normal end of frame tests.
+	}
+
+	//Everything in the grid cells along the path, earliest touch wins.
+	float midX = oldX + moveX / 2;
+	float midZ = oldZ + moveZ / 2;
+	float searchRad = moveLength / 2 + carRad;
+	SweepHit first = { false, 2.0f, 0.0f, 0.0f };
+	bool firstIsWall = false;
+	const BoxObstacleView& wallView = track.walls;
+	track.wallGrid.ForEachRange(midX, midZ, searchRad, [&](GridRange range)
+	{
+		for (int i = range.begin; i < range.end; i++)
+		{
+			SweepHit hit = SweptCircleBox(oldX, oldZ, player.x, player.z, carRad, wallView.x[i], wallView.z[i], wallView.halfWidth[i], wallView.halfDepth[i]);
+			if (hit.hit && hit.time < first.time)
+			{
+				first = hit;
+				firstIsWall = true;
+			}
+		}
+	});
+	const SphereObstacleView* sphereSets[] = { &track.struts, &track.tanks };
+	const GridView* sphereGrids[] = { &track.strutGrid, &track.tankGrid };
+	for (int set = 0; set < 2; set++)
+	{
+		const SphereObstacleView& spheres = *sphereSets[set];
+		sphereGrids[set]->ForEachRange(midX, midZ, searchRad, [&](GridRange range)
+		{
+			for (int i = range.begin; i < range.end; i++)
+			{
+				SweepHit hit = SweptCircleCircle(oldX, oldZ, player.x, player.z, carRad, spheres.x[i], spheres.z[i], spheres.radius[i]);
+				if (hit.hit && hit.time < first.time)
+				{
+					first = hit;
+					firstIsWall = false;
+				}
+			}
+		});
+	}
+	if (!first.hit)
+	{
+		return;
+	}
+
+	//Stop the car where it first touched.  The touch itself is resolved with the rest.
+	float time = std::max(first.time - sweepBackOff / moveLength, 0.0f);
+	player.x = oldX + moveX * time;
+	player.z = oldZ + moveZ * time;
+	found.push_back({ first.normalX, first.normalZ, 0.0f, firstIsWall });
+}
+
+void RaceSimulation::FindContacts(int p)
+{
+	CarState& player = players[p];
+	float oldX = playerOldX[p];
+	float oldZ = playerOldZ[p];
+	std::vector<Contact>& found = contacts[p];
+	found.clear();
+
+	//Fast cars are checked along their whole path first.
+	SweepStaticObstacles(player, oldX, oldZ, found);
+
+	//Walls/isles near the car, eight walls at a time.  A wall is the box grown by the car's radius,
+	//as in car2Box and stored that way, and the car leaves it through the side it came in by.
+	{
+		PROFILE_SCOPE(PhaseWalls);
+		const BoxObstacleView& wallView = track.walls;
+		int hitCount = 0;
+		track.wallGrid.ForEachRange(player.x, player.z, carRad, [&](GridRange range)
+		{
+			hitCount += FindBoxHits(wallView, range.begin, range.end, player.x, player.z, oldX, oldZ,
+				hitScratch.data() + hitCount, sideScratch.data() + hitCount);
+		});
+		for (int h = 0; h < hitCount; h++)
+		{
+			int i = hitScratch[h];
+			float left = player.x - wallView.minX[i];
+			float right = wallView.maxX[i] - player.x;
+			float front = player.z - wallView.minZ[i];
+			float back = wallView.maxZ[i] - player.z;
+
+			//Already inside at the start of the tick: out the shortest way.
+			boxSide side = sideScratch[h];
+			if (side == NoSide)
+			{
+				float shortest = std::min(std::min(left, right), std::min(front, back));
+				side = shortest == left ? LeftSide : (shortest == right ? RightSide : (shortest == front ? FrontSide : BackSide));
+			}
+			Contact contact = { 0.0f, 0.0f, 0.0f, true };
+			switch (side)
+			{
+			case LeftSide: contact.normalX = -1.0f; contact.depth = left; break;
+			case RightSide: contact.normalX = 1.0f; contact.depth = right; break;
+			case FrontSide: contact.normalZ = -1.0f; contact.depth = front; break;
+			default: contact.normalZ = 1.0f; contact.depth = back; break;
+			}
+			found.push_back(contact);
+		}
+	}
+
+	//Checkpoint struts and water tanks.
+	{
+		PROFILE_SCOPE(PhaseStruts);
+		FindSphereContacts(player, track.struts, track.strutGrid, found);
+	}
+	{
+		PROFILE_SCOPE(PhaseTanks);
+		FindSphereContacts(player, track.tanks, track.tankGrid, found);
+	}
+}
+
+void RaceSimulation::ResolveCarHits()
+{
+	//Sorted along z, the long way down the track.
+	int playerCount = PlayerCount();
+	for (int p = 0; p < playerCount; p++)
+	{
+		carX[p] = players[p].x;
+		carZ[p] = players[p].z;
+	}
+	std::copy(ai.x.begin(), ai.x.end(), carX.begin() + playerCount);
+	std::copy(ai.z.begin(), ai.z.end(), carZ.begin() + playerCount);
+	carPairs.clear();
+	int jobs = JobCount(int(carX.size()), sweepJobCars);
+	if (workers == nullptr || jobs == 1)
+	{
+		carSweep.FindPairs(carZ.data(), carX.data(), carRad, carPairs);
+	}
+	else
+	{
+		//The sort is one pass as the order barely changes; the sweep is split by sorted position,
+		//and joining the jobs' pairs in order gives the same list as one sweep.
+		carSweep.Sort(carZ.data());
+		int carCount = int(carX.size());
+		workers->RunJobs(jobs, [this, carCount](int job)
+		{
+			jobPairs[job].clear();
+			carSweep.Sweep(job * sweepJobCars, std::min((job + 1) * sweepJobCars, carCount), carZ.data(), carX.data(), carRad, jobPairs[job]);
+		});
+		for (int job = 0; job < jobs; job++)
+		{
+			carPairs.insert(carPairs.end(), jobPairs[job].begin(), jobPairs[job].end());
+		}
+	}
+
+	for (const CarPair& pair : carPairs)
+	{
+		bool aPlayer = pair.a < playerCount;
+		bool bPlayer = pair.b < playerCount;
+		float& aX = aPlayer ? players[pair.a].x : ai.x[pair.a - playerCount];
+		float& aZ = aPlayer ? players[pair.a].z : ai.z[pair.a - playerCount];
+		float& bX = bPlayer ? players[pair.b].x : ai.x[pair.b - playerCount];
+		float& bZ = bPlayer ? players[pair.b].z : ai.z[pair.b - playerCount];
+		if (!car2Sphere(aX, aZ, carRad, bX, bZ, carRad))
+		{
+			continue; //Only close on one axis, or already pushed apart by an earlier pair.
+		}
+
+		//Each car takes half the overlap along the line between them.  AI cars are pushed there
+		//now; players get a contact, resolved with the rest of their touches.
+		float dx = bX - aX;
+		float dz = bZ - aZ;
+		float distance = sqrt(dx*dx + dz * dz);
+		float normalX = distance > 0.0f ? dx / distance : 1.0f;
+		float normalZ = distance > 0.0f ? dz / distance : 0.0f;
+		float push = (carRad * 2 - distance) / 2;
+		if (aPlayer)
+		{
+			contacts[pair.a].push_back({ -normalX, -normalZ, push, false });
+		}
+		else
+		{
+			aX -= normalX * push;
+			aZ -= normalZ * push;
+		}
+		if (bPlayer)
+		{
+			contacts[pair.b].push_back({ normalX, normalZ, push, false });
+		}
+		else
+		{
+			bX += normalX * push;
+			bZ += normalZ * push;
+		}
+	}
+}
+
+void RaceSimulation::ResolveContacts(CarState& player, std::vector<Contact>& found, float scalarMomentum)
+{
+	PROFILE_SCOPE(PhaseContacts);
+	if (found.empty())
+	{
+		return;
+	}
+
+	//Deepest first, so the order the obstacles were found in makes no difference.
+	std::sort(found.begin(), found.end(), [](const Contact& a, const Contact& b)
+	{
+		return a.depth != b.depth ? a.depth > b.depth : (a.normalX != b.normalX ? a.normalX < b.normalX : a.normalZ < b.normalZ);
+	});
+
+	//Push the car out of everything it is in.  A push out of one may already have cleared another,
+	//and a few passes settle cars wedged between two.
+	float pushX = 0.0f;
+	float pushZ = 0.0f;
+	for (int pass = 0; pass < contactPasses; pass++)
+	{
+		for (const Contact& contact : found)
+		{
+			float left = contact.depth + sweepBackOff - (pushX * contact.normalX + pushZ * contact.normalZ);
+			if (left > 0.0f)
+			{
+				pushX += contact.normalX * left;
+				pushZ += contact.normalZ * left;
+			}
+		}
+	}
+	player.x += pushX;
+	player.z += pushZ;
+
+	//Momentum into a wall is lost and the car slides along it; momentum into anything else bounces
+	//back, scaled down as the old bounce was.  Only a real hit does damage, and only once a tick.
+	float restitution = -1.0f / settings.changeMomentumDirection;
+	float impact = 0.0f;
+	for (const Contact& contact : found)
+	{
+		float into = player.momentum.x * contact.normalX + player.momentum.z * contact.normalZ;
+		if (into < 0.0f)
+		{
+			impact = std::max(impact, -into);
+			float change = contact.slide ? into : into * (1.0f + restitution);
+			player.momentum.x -= contact.normalX * change;
+			player.momentum.z -= contact.normalZ * change;
+		}
+	}
+	if (impact > impactSpeed)
+	{
+		TakeDamage(player, scalarMomentum);
+	}
+}
+
+void RaceSimulation::UpdateBoost(CarState& player, const RaceInput& input)
+{
+	PROFILE_SCOPE(PhaseBoost);
+	//Boost Mode
+	if (input.Held(BoostHeld) && countDown <= 0.0f) //Only executes when count down has ended.  Spacebar held
+	{
+		player.boostDuration -= tickTime; // Amount of time for boost
+		if (player.boostDuration > 0.0f)
+		{
+			player.thrustMultiplier *= thrustChange; //The amount the thrust is multiplied by each tick.
+		}
+	}
+	else
+	{
+		if (player.boostDuration > 0.0f)
+		{
+			player.boostDuration = settings.defaultBoost; //Boost set back to default when space is no longer held.
+			player.thrustMultiplier = settings.defaultThrust;//Boost no longer takes place.
+		}
+	}
+	if (player.boostDuration <= 0.0f)
+	{
+		player.overheatDuration -= tickTime; //Amount of time to recover from overheating.
+		if (player.overheatDuration <= 0.0f)
+		{
+			//When engine has recovered, all values get set back to defaults
+			player.overheatDuration = settings.defaultBoost; //Default duration for overheating
+			player.boostDuration = settings.defaultBoost; //Default duration for boost.
+			player.dragCoeff = settings.defaultDrag;
+			player.thrustMultiplier = settings.defaultThrust;
+		}
+		else
+		{
+			player.dragCoeff *= changeDrag; //The amount drag is multiplied by each tick.
+		}
+	}
+}
+
+void RaceSimulation::UpdateAi()
+{
+	PROFILE_SCOPE(PhaseAi);
+	//Non-player cars only move once the race has started.  Each AI car is timed through its own
+	//next gate, over its whole move this tick.  No car reads another, so big fields are split into jobs.
+	int count = ai.Count();
+	int jobs = workers != nullptr ? JobCount(count, aiJobCars) : 1;
+	auto updateCars = [this, count, jobs](int job)
+	{
+		int first = count * job / jobs;
+		int last = count * (job + 1) / jobs;
+		ai.Update(track.racingLine, settings.aiLoops, settings.nonPlayerCarSpeed, settings.aiLookAhead, tickTime, gameStarted, first, last);
+		for (int i = first; i < last; i++)
+		{
+			laps.Update(gates, PlayerCount() + i, aiOldX[i], aiOldZ[i], ai.x[i], ai.z[i], raceTime);
+		}
+	};
+	if (jobs == 1)
+	{
+		updateCars(0);
+	}
+	else
+	{
+		workers->RunJobs(jobs, updateCars);
+	}
+}
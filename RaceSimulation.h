@@ -0,0 +1,263 @@
+// Jonathan Walsh
+//The race itself: physics, collisions, checkpoints, boost and the AI cars.
+//The simulation never talks to the TL-Engine, it only reads a RaceInput each frame
+//and exposes the car positions for whichever engine is drawing them.
+#pragma once
+#include "AiCars.h"
+#include "LapTracker.h"
+#include "RacePhysics.h"
+#include "SweepAndPrune.h"
+#include "TrackData.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+//Text for the top of the screen: text, then number unless it is negative, then after.  The
+//strings are always literals, so a change shows up as a different pointer or number.
+struct RaceStatus
+{
+	const char* text;
+	int number;
+	const char* after;
+};
+
+//Every key the game reads, one bit each in RaceInput.
+enum InputButton
+{
+	AccelForward, DecelBackward, SteerRight, SteerLeft,
+	StartHit, //Space pressed this frame.
+	BoostHeld, //Space held down.
+	CameraForward, CameraBackward, CameraRight, CameraLeft,
+	ChaseCameraHit, FirstPersonCameraHit, //Camera resets, pressed this frame.
+	InputButtonCount
+};
+
+//Everything the player did in one frame, read once at the start of the frame.  Small and flat
+//so a whole race of it can be logged and replayed (see InputLog.h).
+struct RaceInput
+{
+	uint16_t buttons = 0; //Bit per InputButton.
+	int16_t mouseMoveX = 0;
+	int16_t mouseMoveY = 0;
+
+	bool Held(InputButton button) const { return (buttons >> button & 1) != 0; }
+	void Set(InputButton button, bool down)
+	{
+		buttons = uint16_t(down ? buttons | 1 << button : buttons & ~(1 << button));
+	}
+};
+
+//Buttons that mean "pressed this frame" rather than "held".
+const uint16_t pressButtons = uint16_t(1 << StartHit | 1 << ChaseCameraHit | 1 << FirstPersonCameraHit);
+
+//Tuning values for a race.  The defaults are the values the game ships with.
+struct RaceSettings
+{
+	float defaultBoost = 5.0f;//Initial boost duration.
+	float defaultThrust = 0.1f;//Initial thrust.
+	float defaultDrag = -0.0005f; //Initial drag.
+	float steeringFactor = 100.0f; //Multiplied by frametime to get the steering speed.
+	float realisticSpeed = 1000.0f; //Gives a more realistic, but still proportional on screen value for speed.
+	float changeMomentumDirection = -1.5f;//Chnage the direction the momentum is going.
+	float nonPlayerCarSpeed = 30.0f; //The speed non-player car travels at multiplied by frameTime.
+	float aiLookAhead = 8.0f; //How far down the racing line the AI cars steer towards.
+	float countDown = 3.0f; //3 second countdown until the game starts when you press spacebar.
+	int health = 100; //The initial amount of health the car has before it takes any damage.
+
+	//The initial positions of the player and the first AI car.
+	float initialCarZPos = -30.0f;
+	float initialAiXPos = 10.0f;
+
+	//The AI cars line up in a grid behind the first one.
+	int aiCarCount = 1;
+	int aiGridColumns = 4;
+	float aiGridSpacing = 10.0f;
+	int laps = 1; //Times round every checkpoint to finish.
+	float tickRate = 60.0f; //Physics ticks per second.  Lower runs more races per second, higher is smoother.
+	bool aiLoops = false; //Keep following the waypoints round, otherwise the AI cars drive on past the last one.
+	int playerCount = 1; //Cars driven by people, lined up side by side from the player's spot to the left.
+};
+
+struct CarState
+{
+	float x;
+	float z;
+	float yaw; //Rotation around Y in degrees.
+
+	vector2D momentum;
+	vector2D thrust;
+	vector2D drag;
+
+	//The thrust and drag multipliers, changed by the boost.
+	float thrustMultiplier;
+	float dragCoeff;
+
+	int health;
+	float boostDuration; //The amount of time you can use the boost for.
+	float overheatDuration; //The amount of time it takes for the car to recover when it overheats.
+	float speed; //Speed shown on screen.
+
+	int damageTaken; //Total health lost, including health given back when it ran out.
+	int collisions; //Number of obstacles hit.
+};
+
+//Where the race is up to, for the player.
+enum RaceState : uint8_t
+{
+	StateWaiting, StateCountingDown, StateRacing, StateFinished
+};
+
+//The rate the tuning values above were made for: the original game applied them once per frame at 60 fps.
+const float referenceTickRate = 60.0f;
+const float maxFrameTime = 0.25f; //A longer frame (a breakpoint, a stall) is cut short rather than run as hundreds of ticks.
+
+struct CarPose
+{
+	float x;
+	float z;
+	float yaw;
+};
+
+class RaceSimulation
+{
+public:
+	//The track data must outlive the simulation; several simulations can share one track.
+	RaceSimulation(const TrackData& track, const RaceSettings& settings = RaceSettings());
+
+	//Runs as many fixed ticks as fit in the time since the last frame, carrying the remainder
+	//over, and returns how many ran.  Physics is the same whatever the frame rate.
+	int Advance(const RaceInput& input, float frameTime);
+	//The same, calling afterTick() after each tick, for recording that has to see every tick.
+	template <class AfterTick>
+	int Advance(const RaceInput& input, float frameTime, AfterTick afterTick)
+	{
+		//Presses are kept until a tick runs, so a short frame with no tick in it does not lose them.
+		pendingPresses |= input.buttons & pressButtons;
+		accumulator += std::min(frameTime, maxFrameTime);
+
+		int ticks = 0;
+		while (accumulator >= tickTime)
+		{
+			RaceInput tickInput = input;
+			tickInput.buttons = uint16_t((input.buttons & ~pressButtons) | pendingPresses);
+			pendingPresses = 0; //A press only counts on the first tick of the frame.
+			Step(tickInput);
+			accumulator -= tickTime;
+			ticks++;
+			afterTick();
+		}
+		return ticks;
+	}
+	void Step(const RaceInput& input); //Runs one tick, with input for the first player only.
+	void Step(const RaceInput* inputs); //Runs one tick with one input per player.
+	float TickTime() const { return tickTime; }
+
+	//Splits the AI cars and the car broadphase into jobs on the pool once there are enough cars to
+	//be worth it.  The pool must not be used for anything else while a tick runs; null runs
+	//everything on the calling thread.  Either way the race comes out the same to the bit.
+	void SetWorkers(ThreadPool* pool);
+	float Interpolation() const { return accumulator / tickTime; } //How far the next tick has got, 0 to 1.
+
+	//Where a car is drawn: between its positions at the last two ticks, Interpolation() of the way along.
+	CarPose PlayerPose(int player = 0) const;
+	CarPose AiPose(int car) const;
+
+	const TrackData& Track() const { return track; }
+	const RaceSettings& Settings() const { return settings; }
+	const CarState& Player(int player = 0) const { return players[player]; }
+	int PlayerCount() const { return int(players.size()); }
+	const AiCars& Ai() const { return ai; }
+
+	const CheckpointGates& Gates() const { return gates; }
+	const LapTracker& Laps() const { return laps; } //The players come first, then AI car i is car PlayerCount() + i.
+	int NextCheckpoint(int player = 0) const { return laps.NextGate(player); }
+
+	//Every car sorted along z, and where each was, as of this tick's car collisions.  Numbered the same as the laps.
+	const std::vector<int>& CarOrder() const { return carSweep.Order(); }
+	const std::vector<float>& CarX() const { return carX; }
+	const std::vector<float>& CarZ() const { return carZ; }
+	bool Finished() const; //Every player has finished.
+	RaceState State() const { return Finished() ? StateFinished : (gameStarted ? StateRacing : (countingDown ? StateCountingDown : StateWaiting)); }
+	const RaceStatus& Status() const { return status; } //Countdown and stage text.
+	bool GameStarted() const { return gameStarted; }
+	bool OutOfBounds() const { return outOfBounds; } //The first player has left the course.
+	float CountDownLeft() const { return countDown; }
+	float RaceTime() const { return raceTime; } //Seconds since the countdown finished.
+	int FrameCount() const { return frameCount; }
+
+private:
+	void UpdatePlayer(CarState& player, const RaceInput& input);
+	void UpdateCountDown(const RaceInput* inputs);
+	void UpdateCheckpoints(int car, float oldX, float oldZ);
+	//A touch found this tick: the way out of the obstacle, how far in the car is, and whether it
+	//slides along (walls) or bounces off (struts, tanks and other cars).
+	struct Contact
+	{
+		float normalX;
+		float normalZ;
+		float depth;
+		bool slide;
+	};
+
+	void UpdateBoost(CarState& player, const RaceInput& input);
+	void UpdateAi();
+	void TakeDamage(CarState& player, float scalarMomentum);
+
+	//Every touch with walls, struts and tanks is collected first, then the car touches with
+	//ResolveCarHits, and each player's list is resolved once in ResolveContacts.
+	void FindContacts(int player);
+	void SweepStaticObstacles(CarState& player, float oldX, float oldZ, std::vector<Contact>& found);
+	void FindSphereContacts(const CarState& player, const SphereObstacleView& spheres, const GridView& grid, std::vector<Contact>& found);
+	void ResolveCarHits();
+	void ResolveContacts(CarState& player, std::vector<Contact>& found, float scalarMomentum);
+
+	const TrackData& track;
+	RaceSettings settings;
+	std::vector<CarState> players;
+	AiCars ai;
+
+	//Each player's position and speed at the start of the tick, for bouncing back off other cars.
+	std::vector<float> playerOldX;
+	std::vector<float> playerOldZ;
+	std::vector<float> playerMomentum;
+	std::vector<RaceInput> tickInputs; //Step with one input fills in the first and leaves the rest empty.
+
+	std::vector<int> hitScratch; //Indices of the obstacles hit this frame.
+	std::vector<boxSide> sideScratch;
+	std::vector<std::vector<Contact>> contacts; //Each player's touches this tick.
+
+	//Car against car, numbered the same as the laps.
+	SweepAndPrune carSweep;
+	std::vector<float> carX;
+	std::vector<float> carZ;
+	std::vector<CarPair> carPairs;
+
+	ThreadPool* workers = nullptr;
+	std::vector<std::vector<CarPair>> jobPairs; //Each broadphase job's pairs, joined in job order.
+
+	CheckpointGates gates;
+	LapTracker laps;
+	std::vector<float> aiOldX; //Where the AI cars were before this frame's move, for their gates.
+	std::vector<float> aiOldZ;
+	std::vector<float> aiOldHeadingX; //Which way the AI cars faced before this frame's move, for drawing between ticks.
+	std::vector<float> aiOldHeadingZ;
+	RaceStatus status = { "Hit Space to Start. . .", -1, "" }; //User prompt
+
+	//Fixed timestep.
+	float tickTime;
+	float tickScale; //Tick length in 60ths of a second.
+	float thrustChange; //Boost and overheat growth per tick.
+	float changeDrag;
+	float accumulator = 0.0f; //Time not yet simulated.
+	uint16_t pendingPresses = 0; //Presses waiting for the next tick.
+	std::vector<CarPose> previousPlayers;
+	float countDown;
+	bool countingDown = false; //Counting down becomes true when spacebar has been pressed in order to start the countdown.
+	bool gameStarted = false; //Becomes true when the count down has finished.
+	bool outOfBounds = false; //Becomes true when the player leaves the course.
+	float courseRadius = maxDistance; //Distance from the origin where the course ends.
+	float raceTime = 0.0f;
+	int frameCount = 0;
+};
@@ -0,0 +1,7 @@
+// Jonathan Walsh
+#include "RaceTrack.h"
+
+RaceTrack DefaultTrack()
+{
+	return defaultTrackSource.ToRaceTrack();
+}
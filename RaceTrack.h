@@ -0,0 +1,101 @@
+// Jonathan Walsh
+//Layout of a track: where every checkpoint, strut, isle, wall, tank and waypoint sits.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <vector>
+
+struct RaceTrack
+{
+	//Checkpoint X and Z coordinates and their rotation around Y in degrees.
+	std::vector<float> checkpointX;
+	std::vector<float> checkpointZ;
+	std::vector<float> checkpointRotation;
+
+	//The little stumps on each side of the checkpoints.
+	std::vector<float> strutX;
+	std::vector<float> strutZ;
+
+	//The X and Z coordinates for each of the isle models.
+	std::vector<float> isleX;
+	std::vector<float> isleZ;
+
+	//The X and Z coordinates of each of the wall models.
+	std::vector<float> wallX;
+	std::vector<float> wallZ;
+
+	//The X, Y and Z coordinates of each of the tank models and their tilt around X in degrees.
+	std::vector<float> tankX;
+	std::vector<float> tankY;
+	std::vector<float> tankZ;
+	std::vector<float> tankRotation;
+
+	//The X and Z coordinates of each of the waypoints(dummies) the AI drives to.
+	std::vector<float> waypointX;
+	std::vector<float> waypointZ;
+};
+
+//The same layout in fixed-size arrays, so a track written into the program can be baked at compile
+//time (see CompiledTrack.h).
+template <size_t Checkpoints, size_t Struts, size_t Isles, size_t Walls, size_t Tanks, size_t Waypoints>
+struct TrackSource
+{
+	std::array<float, Checkpoints> checkpointX;
+	std::array<float, Checkpoints> checkpointZ;
+	std::array<float, Checkpoints> checkpointRotation;
+	std::array<float, Struts> strutX;
+	std::array<float, Struts> strutZ;
+	std::array<float, Isles> isleX;
+	std::array<float, Isles> isleZ;
+	std::array<float, Walls> wallX;
+	std::array<float, Walls> wallZ;
+	std::array<float, Tanks> tankX;
+	std::array<float, Tanks> tankY;
+	std::array<float, Tanks> tankZ;
+	std::array<float, Tanks> tankRotation;
+	std::array<float, Waypoints> waypointX;
+	std::array<float, Waypoints> waypointZ;
+
+	RaceTrack ToRaceTrack() const
+	{
+		RaceTrack track;
+		track.checkpointX.assign(checkpointX.begin(), checkpointX.end());
+		track.checkpointZ.assign(checkpointZ.begin(), checkpointZ.end());
+		track.checkpointRotation.assign(checkpointRotation.begin(), checkpointRotation.end());
+		track.strutX.assign(strutX.begin(), strutX.end());
+		track.strutZ.assign(strutZ.begin(), strutZ.end());
+		track.isleX.assign(isleX.begin(), isleX.end());
+		track.isleZ.assign(isleZ.begin(), isleZ.end());
+		track.wallX.assign(wallX.begin(), wallX.end());
+		track.wallZ.assign(wallZ.begin(), wallZ.end());
+		track.tankX.assign(tankX.begin(), tankX.end());
+		track.tankY.assign(tankY.begin(), tankY.end());
+		track.tankZ.assign(tankZ.begin(), tankZ.end());
+		track.tankRotation.assign(tankRotation.begin(), tankRotation.end());
+		track.waypointX.assign(waypointX.begin(), waypointX.end());
+		track.waypointZ.assign(waypointZ.begin(), waypointZ.end());
+		return track;
+	}
+};
+
+//The original course from the assignment.
+inline constexpr TrackSource<4, 8, 14, 7, 6, 7> defaultTrackSource =
+{
+	{ 0.0f, 0.0f, 30.0f, 60.0f }, //Checkpoints.
+	{ 0.0f, 100.0f, 155.0f, 100.0f },
+	{ 0.0f, 0.0f, 90.0f, 0.0f }, //Third checkpoint faces to the right rather than forwards.
+	{ -8.0f, 9.0f, -8.0f, 9.0f, 30.0f, 30.0f, 52.0f, 69.0f }, //Struts.
+	{ 0.0f, 0.0f, 100.0f, 100.0f, 146.0f, 164.0f, 100.0f, 100.0f },
+	{ -10.0f, -10.0f, 10.0f, 10.0f, -10.0f, -10.0f, 50.0f, 50.0f, 65.0f, 65.0f, 50.0f, 50.0f, 65.0f, 65.0f }, //Isles.
+	{ 40.0f, 53.0f, 40.0f, 53.0f, 130.0f, 143.0f, 114.0f, 127.0f, 114.0f, 127.0f, 74.0f, 87.0f, 74.0f, 87.0f },
+	{ -10.5f, 9.5f, -10.5f, 50.0f, 65.0f, 50.0f, 65.0f }, //Walls.
+	{ 46.0f, 46.0f, 136.0f, 120.0f, 120.0f, 80.0f, 80.0f },
+	{ -5.0f, 10.0f, 9.5f, 25.0f, 0.0f, 45.0f }, //Tanks.
+	{ 0.0f, 0.0f, 0.0f, 0.0f, -5.0f, 0.0f },
+	{ 175.0f, 175.0f, 136.0f, 175.0f, 70.0f, 145.0f },
+	{ 0.0f, 0.0f, 0.0f, 0.0f, 25.0f, 0.0f }, //Fifth tank is half sunk and tilted.
+	{ 0.0f, -5.0f, 0.0f, 0.0f, 60.0f, 70.0f, 57.0f }, //Waypoints.
+	{ 30.0f, 70.0f, 100.0f, 145.0f, 155.0f, 110.0f, 10.0f }
+};
+
+RaceTrack DefaultTrack(); //defaultTrackSource as a RaceTrack.
@@ -0,0 +1,113 @@
+// Jonathan Walsh
+#include "RacingLine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const int stepsPerSample = 8; //Curve steps walked for each sample, to measure its length.
+
+	void CurvePoint(const float* px, const float* pz, int n, int i, float t, float& x, float& z)
+	{
+		int a = (i + n - 1) % n;
+		int b = i;
+		int c = (i + 1) % n;
+		int d = (i + 2) % n;
+		float t2 = t * t;
+		float t3 = t2 * t;
+		x = 0.5f * (2 * px[b] + (px[c] - px[a]) * t + (2 * px[a] - 5 * px[b] + 4 * px[c] - px[d]) * t2 + (3 * px[b] - px[a] - 3 * px[c] + px[d]) * t3);
+		z = 0.5f * (2 * pz[b] + (pz[c] - pz[a]) * t + (2 * pz[a] - 5 * pz[b] + 4 * pz[c] - pz[d]) * t2 + (3 * pz[b] - pz[a] - 3 * pz[c] + pz[d]) * t3);
+	}
+}
+
+void RacingLine::Build(const float* waypointX, const float* waypointZ, int n, float spacing)
+{
+	x.clear();
+	z.clear();
+	headingX.clear();
+	headingZ.clear();
+	speed.clear();
+	params = { spacing, 0.0f, 0.0f, 0 };
+	if (n < 2)
+	{
+		return;
+	}
+
+	//Walk each curve segment in small steps and drop a sample every spacing along it.
+	float lastX = waypointX[0], lastZ = waypointZ[0];
+	float travelled = 0.0f; //Total length walked.
+	float nextSample = 0.0f;
+	for (int i = 0; i < n; i++)
+	{
+		float dx = waypointX[(i + 1) % n] - waypointX[i];
+		float dz = waypointZ[(i + 1) % n] - waypointZ[i];
+		int steps = std::max(stepsPerSample, int(std::sqrt(dx*dx + dz * dz) / spacing * stepsPerSample));
+		for (int s = 1; s <= steps; s++)
+		{
+			float px, pz;
+			CurvePoint(waypointX, waypointZ, n, i, float(s) / steps, px, pz);
+			float length = std::sqrt((px - lastX) * (px - lastX) + (pz - lastZ) * (pz - lastZ));
+			while (length > 0.0f && nextSample <= travelled + length)
+			{
+				float t = (nextSample - travelled) / length;
+				x.push_back(lastX + (px - lastX) * t);
+				z.push_back(lastZ + (pz - lastZ) * t);
+				nextSample += spacing;
+			}
+			travelled += length;
+			lastX = px;
+			lastZ = pz;
+		}
+		if (i == n - 2)
+		{
+			params.openLength = travelled;
+		}
+	}
+	params.loopLength = travelled;
+	int count = int(x.size());
+	params.count = count;
+
+	//Headings from the samples either side, and the tightest speed each bend allows.
+	headingX.resize(count);
+	headingZ.resize(count);
+	speed.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		int next = (i + 1) % count;
+		int previous = (i + count - 1) % count;
+		float dx = x[next] - x[previous];
+		float dz = z[next] - z[previous];
+		float length = std::sqrt(dx*dx + dz * dz);
+		headingX[i] = length > 0.0f ? dx / length : 0.0f;
+		headingZ[i] = length > 0.0f ? dz / length : 1.0f;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		int next = (i + 1) % count;
+		int previous = (i + count - 1) % count;
+		float turn = std::acos(std::min(1.0f, headingX[previous] * headingX[next] + headingZ[previous] * headingZ[next]));
+		float curvature = turn / (2 * spacing);
+		speed[i] = curvature > 0.0f ? std::min(lineSpeedLimit, std::sqrt(aiCornerGrip / curvature)) : lineSpeedLimit;
+	}
+
+	//Slow down in time for each corner: going backwards, no sample is faster than braking from it reaches the next.
+	//Twice round, so the corners at the start are braked for at the end of the loop.
+	float brakeGain = 2 * aiBraking * spacing;
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = count - 1; i >= 0; i--)
+		{
+			float after = speed[(i + 1) % count];
+			speed[i] = std::min(speed[i], std::sqrt(after * after + brakeGain));
+		}
+	}
+}
+
+RacingLineView RacingLine::View() const
+{
+	if (params.count == 0)
+	{
+		return { params, nullptr, nullptr, nullptr, nullptr, nullptr };
+	}
+	return { params, x.data(), z.data(), headingX.data(), headingZ.data(), speed.data() };
+}
@@ -0,0 +1,67 @@
+// Jonathan Walsh
+//The line the AI cars drive.  The waypoints are joined by a smooth curve and sampled at even
+//distances along it, so a car only keeps how far along the line it is and reads the sample there:
+//where the line is, which way it runs and how fast it can be taken.  The line is built once, when
+//the track is baked, and saved in the .htrk file with everything else.
+#pragma once
+#include <vector>
+
+const float racingLineSpacing = 1.0f; //Distance between samples.
+const float aiCornerGrip = 40.0f; //Sideways acceleration the AI cars can corner at.
+const float aiBraking = 30.0f; //How hard the AI cars slow down for a corner ahead.
+const float lineSpeedLimit = 1000.0f; //Target speed on the straights, before the car's own top speed.
+
+struct RacingLineParams
+{
+	float spacing;
+	float openLength; //Distance to the last waypoint.
+	float loopLength; //Distance round to the first waypoint again.
+	int count;
+};
+
+//Read-only line, pointing at samples owned by a RacingLine or mapped from a track file.
+struct RacingLineView
+{
+	RacingLineParams params;
+	const float* x;
+	const float* z;
+	const float* headingX; //Unit direction of the line.
+	const float* headingZ;
+	const float* speed; //Fastest the corner here and the braking for the ones ahead allow.
+
+	//The sample at a distance along the line.  Before the start it is the first sample, and past the
+	//last waypoint it is the sample there, unless looping round.
+	int Sample(float distance, bool loop) const
+	{
+		int i = int(distance / params.spacing);
+		if (i < 0)
+		{
+			return 0;
+		}
+		if (loop)
+		{
+			return i % params.count;
+		}
+		int last = int(params.openLength / params.spacing);
+		return i > last ? last : i;
+	}
+};
+
+class RacingLine
+{
+public:
+	//Joins the waypoints with a closed Catmull-Rom curve.  Fewer than two waypoints give an empty line.
+	void Build(const float* waypointX, const float* waypointZ, int waypointCount, float spacing = racingLineSpacing);
+
+	RacingLineView View() const;
+	const RacingLineParams& Params() const { return params; }
+
+	std::vector<float> x;
+	std::vector<float> z;
+	std::vector<float> headingX;
+	std::vector<float> headingZ;
+	std::vector<float> speed;
+
+private:
+	RacingLineParams params = { racingLineSpacing, 0.0f, 0.0f, 0 };
+};
@@ -0,0 +1,31 @@
+// Jonathan Walsh
+#include "ReplayRaceEngine.h"
+
+ReplayRaceEngine::ReplayRaceEngine(const InputLog& log)
+	: log(log), running(!log.Records().empty())
+{
+}
+
+float ReplayRaceEngine::Timer()
+{
+	if (!timerStarted)
+	{
+		timerStarted = true;
+		return 0.0f;
+	}
+	return log.Records()[frame].frameTime;
+}
+
+void ReplayRaceEngine::ReadInput(RaceInput& input)
+{
+	input = log.Records()[frame].input;
+}
+
+void ReplayRaceEngine::Present(const RaceFrame&, float)
+{
+	frame++;
+	if (frame >= int(log.Records().size()))
+	{
+		running = false; //The end of the recording.
+	}
+}
@@ -0,0 +1,26 @@
+// Jonathan Walsh
+//Headless backend that plays an InputLog back: each frame gets the recorded frame time and
+//input, with no window and no waiting, so a recorded race is rerun as fast as the CPU allows.
+#pragma once
+#include "RaceEngine.h"
+#include "InputLog.h"
+
+class ReplayRaceEngine : public IRaceEngine
+{
+public:
+	explicit ReplayRaceEngine(const InputLog& log);
+
+	bool IsRunning() override { return running; }
+	float Timer() override;
+	void ReadInput(RaceInput& input) override;
+	void Present(const RaceFrame& frame, float frameTime) override;
+	void Stop() override { running = false; }
+
+	int FramesRun() const { return frame; }
+
+private:
+	const InputLog& log;
+	int frame = 0;
+	bool timerStarted = false; //RunRace calls Timer once before the first frame to start it.
+	bool running;
+};
@@ -0,0 +1,107 @@
+// Jonathan Walsh
+#include "SpatialGrid.h"
+#include <cmath>
+
+namespace
+{
+	//Puts values into the order given by order.
+	void Reorder(std::vector<float>& values, const std::vector<int>& order)
+	{
+		std::vector<float> sorted(values.size());
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			sorted[i] = values[order[i]];
+		}
+		values.swap(sorted);
+	}
+}
+
+void SpatialGrid::Build(const float* x, const float* z, int count, float reach, float cellSize, std::vector<int>& order)
+{
+	order.resize(count);
+	cellStart.clear();
+	params = { 0.0f, 0.0f, cellSize, reach, 0, 0 };
+	if (count == 0)
+	{
+		return;
+	}
+
+	//Grid covers the obstacle centres.
+	float minX = x[0], maxX = x[0], minZ = z[0], maxZ = z[0];
+	for (int i = 1; i < count; i++)
+	{
+		minX = std::min(minX, x[i]);
+		maxX = std::max(maxX, x[i]);
+		minZ = std::min(minZ, z[i]);
+		maxZ = std::max(maxZ, z[i]);
+	}
+	params.originX = minX;
+	params.originZ = minZ;
+	for (;;)
+	{
+		params.cellsX = int((maxX - minX) / params.cellSize) + 1;
+		params.cellsZ = int((maxZ - minZ) / params.cellSize) + 1;
+		if (double(params.cellsX) * params.cellsZ <= maxGridCells)
+		{
+			break;
+		}
+		params.cellSize *= 2.0f;
+	}
+
+	//Counting sort by cell: count each cell, turn the counts into start offsets, then place each obstacle.
+	GridView view = View();
+	std::vector<int> cellOf(count);
+	cellStart.assign(CellCount() + 1, 0);
+	for (int i = 0; i < count; i++)
+	{
+		int cellX = std::min(view.CellX(x[i]), params.cellsX - 1);
+		int cellZ = std::min(view.CellZ(z[i]), params.cellsZ - 1);
+		cellOf[i] = cellZ * params.cellsX + cellX;
+		cellStart[cellOf[i] + 1]++;
+	}
+	for (size_t c = 1; c < cellStart.size(); c++)
+	{
+		cellStart[c] += cellStart[c - 1];
+	}
+	std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+	for (int i = 0; i < count; i++)
+	{
+		order[fill[cellOf[i]]++] = i; //Keeps the original order within a cell.
+	}
+}
+
+void BuildGrid(BoxObstacles& boxes, SpatialGrid& grid, float cellSize)
+{
+	float reach = 0.0f;
+	for (int i = 0; i < boxes.Count(); i++)
+	{
+		reach = std::max(reach, std::max(boxes.halfWidth[i], boxes.halfDepth[i]));
+	}
+
+	std::vector<int> order;
+	grid.Build(boxes.x.data(), boxes.z.data(), boxes.Count(), reach, cellSize, order);
+	Reorder(boxes.x, order);
+	Reorder(boxes.z, order);
+	Reorder(boxes.halfWidth, order);
+	Reorder(boxes.halfDepth, order);
+	Reorder(boxes.minX, order);
+	Reorder(boxes.maxX, order);
+	Reorder(boxes.minZ, order);
+	Reorder(boxes.maxZ, order);
+}
+
+void BuildGrid(SphereObstacles& spheres, SpatialGrid& grid, float cellSize)
+{
+	float reach = 0.0f;
+	for (int i = 0; i < spheres.Count(); i++)
+	{
+		reach = std::max(reach, spheres.radius[i]);
+	}
+
+	std::vector<int> order;
+	grid.Build(spheres.x.data(), spheres.z.data(), spheres.Count(), reach, cellSize, order);
+	Reorder(spheres.x, order);
+	Reorder(spheres.z, order);
+	Reorder(spheres.radius, order);
+	Reorder(spheres.touchSq, order);
+}
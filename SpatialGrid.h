@@ -0,0 +1,98 @@
+// Jonathan Walsh
+//Uniform grid broadphase for the static obstacles.  Built once when the track loads: each
+//obstacle goes in the cell under its centre and the obstacle store is sorted by cell, so the
+//cells in one row of the grid cover one unbroken range of the store.  A query only hands
+//back the ranges under the car, which the SIMD kernels then test as normal.
+#pragma once
+#include "ObstacleStore.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+constexpr float defaultCellSize = 16.0f; //About twice the car's diameter.
+constexpr int maxGridCells = 1 << 22; //The cell size grows on huge tracks to keep the grid under this.
+
+struct GridRange
+{
+	int begin;
+	int end;
+};
+
+struct GridParams
+{
+	float originX;
+	float originZ;
+	float cellSize;
+	float reach; //Largest distance from an obstacle's centre to its edge.
+	int cellsX;
+	int cellsZ;
+};
+
+//Read-only grid, pointing at cell offsets owned by a SpatialGrid or mapped from a track file.
+struct GridView
+{
+	GridParams params;
+	const int* cellStart; //Cell c holds the obstacles cellStart[c] to cellStart[c + 1].
+
+	//Calls fn(range) for each row of cells that anything within radius of (x, z) could be in.
+	template <class Fn>
+	void ForEachRange(float x, float z, float radius, Fn fn) const
+	{
+		if (cellStart == nullptr || params.cellsX == 0)
+		{
+			return;
+		}
+		float search = radius + params.reach; //Obstacles are filed by centre, so widen the search by their size.
+		int minCellX = std::max(CellX(x - search), 0);
+		int maxCellX = std::min(CellX(x + search), params.cellsX - 1);
+		int minCellZ = std::max(CellZ(z - search), 0);
+		int maxCellZ = std::min(CellZ(z + search), params.cellsZ - 1);
+		if (minCellX > maxCellX || minCellZ > maxCellZ)
+		{
+			return; //Wholly off the grid.
+		}
+		for (int row = minCellZ; row <= maxCellZ; row++)
+		{
+			GridRange range = { cellStart[row * params.cellsX + minCellX], cellStart[row * params.cellsX + maxCellX + 1] };
+			if (range.begin < range.end)
+			{
+				fn(range);
+			}
+		}
+	}
+
+	int CellX(float x) const { return CellOf((x - params.originX) / params.cellSize, params.cellsX); }
+	int CellZ(float z) const { return CellOf((z - params.originZ) / params.cellSize, params.cellsZ); }
+
+	//Clamped to -1 to cells before the cast, as far off positions would overflow an int.  NaN gives
+	//-1, which leaves a query at NaN with no cells.
+	static int CellOf(float cell, int cells)
+	{
+		cell = std::floor(cell);
+		if (!(cell >= -1.0f))
+		{
+			return -1;
+		}
+		return cell > float(cells) ? cells : int(cell);
+	}
+};
+
+class SpatialGrid
+{
+public:
+	//order is filled with the obstacle indices sorted by cell.
+	void Build(const float* x, const float* z, int count, float reach, float cellSize, std::vector<int>& order);
+
+	GridView View() const { return { params, cellStart.empty() ? nullptr : cellStart.data() }; }
+	int CellCount() const { return params.cellsX * params.cellsZ; }
+	const GridParams& Params() const { return params; }
+	const std::vector<int>& CellStarts() const { return cellStart; }
+
+private:
+	GridParams params = { 0.0f, 0.0f, defaultCellSize, 0.0f, 0, 0 };
+	std::vector<int> cellStart;
+};
+
+//Sorts the store into cell order and builds its grid.
+void BuildGrid(BoxObstacles& boxes, SpatialGrid& grid, float cellSize = defaultCellSize);
+void BuildGrid(SphereObstacles& spheres, SpatialGrid& grid, float cellSize = defaultCellSize);
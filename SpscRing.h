@@ -0,0 +1,79 @@
+// Jonathan Walsh
+//Lock-free ring for one producer thread and one consumer thread.  Each side owns one index and
+//only reads the other's, and each keeps its last look at the other's index so it only touches
+//the shared cache line when the ring seems full (or empty).
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+template <class T>
+class SpscRing
+{
+public:
+	explicit SpscRing(size_t capacity) //Rounded up to a power of two.
+	{
+		size_t size = 1;
+		while (size < capacity)
+		{
+			size *= 2;
+		}
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	SpscRing(const SpscRing&) = delete;
+	SpscRing& operator=(const SpscRing&) = delete;
+
+	//Producer only, for filling items in place.  Reserve returns how many of count slots are free,
+	//Slot(i) is the i-th of them and Commit hands the first count of them to the consumer.
+	size_t Reserve(size_t count)
+	{
+		size_t head = writeIndex.load(std::memory_order_relaxed);
+		if (slots.size() - (head - cachedRead) < count)
+		{
+			cachedRead = readIndex.load(std::memory_order_acquire);
+		}
+		return std::min(count, slots.size() - (head - cachedRead));
+	}
+
+	T& Slot(size_t i)
+	{
+		return slots[(writeIndex.load(std::memory_order_relaxed) + i) & mask];
+	}
+
+	void Commit(size_t count)
+	{
+		writeIndex.store(writeIndex.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+	//Consumer only.  Takes up to most items, oldest first, and returns how many it took.
+	size_t PopMany(T* out, size_t most)
+	{
+		size_t tail = readIndex.load(std::memory_order_relaxed);
+		if (cachedWrite - tail < most)
+		{
+			cachedWrite = writeIndex.load(std::memory_order_acquire);
+		}
+		size_t count = std::min(most, cachedWrite - tail);
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = slots[(tail + i) & mask];
+		}
+		readIndex.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	size_t Capacity() const { return slots.size(); }
+
+private:
+	std::vector<T> slots;
+	size_t mask;
+
+	//Producer's side and consumer's side on their own cache lines.
+	alignas(64) std::atomic<size_t> writeIndex{ 0 };
+	size_t cachedRead = 0;
+	alignas(64) std::atomic<size_t> readIndex{ 0 };
+	size_t cachedWrite = 0;
+};
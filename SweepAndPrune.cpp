@@ -0,0 +1,67 @@
+// Jonathan Walsh
+#include "SweepAndPrune.h"
+#include <algorithm>
+#include <cmath>
+
+void SweepAndPrune::Resize(int count)
+{
+	order.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	sorted = false;
+}
+
+int SweepAndPrune::FindPairs(const float* sweep, const float* other, float radius, std::vector<CarPair>& pairs)
+{
+	Sort(sweep);
+	return Sweep(0, Count(), sweep, other, radius, pairs);
+}
+
+void SweepAndPrune::Sort(const float* sweep)
+{
+	//Insertion sort from last frame's order, only cars that overtook another move.  The first
+	//time there is no order to start from, so it is a full sort instead.
+	int count = Count();
+	if (!sorted)
+	{
+		std::sort(order.begin(), order.end(), [sweep](int a, int b) { return sweep[a] < sweep[b]; });
+		sorted = true;
+	}
+	int* sortedCars = order.data();
+	for (int i = 1; i < count; i++)
+	{
+		int car = sortedCars[i];
+		float key = sweep[car];
+		int j = i - 1;
+		while (j >= 0 && sweep[sortedCars[j]] > key)
+		{
+			sortedCars[j + 1] = sortedCars[j];
+			j--;
+		}
+		sortedCars[j + 1] = car;
+	}
+}
+
+int SweepAndPrune::Sweep(int first, int last, const float* sweep, const float* other, float radius, std::vector<CarPair>& pairs) const
+{
+	//Every car after this one that starts before it ends is a candidate.
+	int count = Count();
+	const int* sortedCars = order.data();
+	float reach = radius * 2;
+	size_t before = pairs.size();
+	for (int i = first; i < last; i++)
+	{
+		int a = sortedCars[i];
+		for (int j = i + 1; j < count && sweep[sortedCars[j]] - sweep[a] <= reach; j++)
+		{
+			int b = sortedCars[j];
+			if (std::fabs(other[b] - other[a]) <= reach)
+			{
+				pairs.push_back({ a, b });
+			}
+		}
+	}
+	return int(pairs.size() - before);
+}
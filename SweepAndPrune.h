@@ -0,0 +1,35 @@
+// Jonathan Walsh
+//Sort-and-sweep broadphase for the cars.  The cars are kept sorted along one axis and only
+//cars whose extents overlap on that axis are tested on the other.  The order is kept from frame
+//to frame, and as the cars barely move in a frame an insertion sort puts it right again in
+//close to one pass.
+#pragma once
+#include <vector>
+
+struct CarPair
+{
+	int a;
+	int b;
+};
+
+class SweepAndPrune
+{
+public:
+	void Resize(int count); //Starts again from the cars in index order.
+	int Count() const { return int(order.size()); }
+
+	//Appends every pair of circles of the given radius whose extents overlap on both axes.
+	//sweep is the axis the cars are sorted along, other is the axis across it.  Returns the pair count.
+	int FindPairs(const float* sweep, const float* other, float radius, std::vector<CarPair>& pairs);
+
+	//FindPairs in two halves, so the sweep can be split across threads.  Sort puts the order right,
+	//then Sweep appends the pairs starting at sorted positions first to last - 1, reading the order only.
+	void Sort(const float* sweep);
+	int Sweep(int first, int last, const float* sweep, const float* other, float radius, std::vector<CarPair>& pairs) const;
+
+	const std::vector<int>& Order() const { return order; }
+
+private:
+	std::vector<int> order; //Car indices sorted along the sweep axis as of the last FindPairs.
+	bool sorted = false; //False until the first FindPairs, which sorts from scratch.
+};
@@ -0,0 +1,122 @@
+// Jonathan Walsh
+#include "SweptCollision.h"
+#include <cmath>
+
+namespace
+{
+	const SweepHit noHit = { false, 1.0f, 0.0f, 0.0f };
+}
+
+SweepHit SweptCircleBox(float startX, float startZ, float endX, float endZ, float carRad,
+	float boxX, float boxZ, float halfWidth, float halfDepth)
+{
+	float minX = boxX - halfWidth - carRad;
+	float maxX = boxX + halfWidth + carRad;
+	float minZ = boxZ - halfDepth - carRad;
+	float maxZ = boxZ + halfDepth + carRad;
+	float moveX = endX - startX;
+	float moveZ = endZ - startZ;
+
+	//Already inside: push out through the nearest face.
+	if (startX > minX && startX < maxX && startZ > minZ && startZ < maxZ)
+	{
+		float toLeft = startX - minX, toRight = maxX - startX, toFront = startZ - minZ, toBack = maxZ - startZ;
+		float nearestX = std::fmin(toLeft, toRight);
+		float nearestZ = std::fmin(toFront, toBack);
+		if (nearestX < nearestZ)
+		{
+			return { true, 0.0f, toLeft < toRight ? -1.0f : 1.0f, 0.0f };
+		}
+		return { true, 0.0f, 0.0f, toFront < toBack ? -1.0f : 1.0f };
+	}
+
+	//Slab test: the point start + move * t is inside the grown box between entry and exit.
+	float entry = 0.0f;
+	float exit = 1.0f;
+	float normalX = 0.0f;
+	float normalZ = 0.0f;
+	const float axisMin[2] = { minX, minZ };
+	const float axisMax[2] = { maxX, maxZ };
+	const float axisStart[2] = { startX, startZ };
+	const float axisMove[2] = { moveX, moveZ };
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (axisMove[axis] == 0.0f)
+		{
+			if (axisStart[axis] <= axisMin[axis] || axisStart[axis] >= axisMax[axis])
+			{
+				return noHit; //Moving alongside the box without ever overlapping it.
+			}
+			continue;
+		}
+		float entryTime = (axisMin[axis] - axisStart[axis]) / axisMove[axis];
+		float exitTime = (axisMax[axis] - axisStart[axis]) / axisMove[axis];
+		float side = -1.0f; //Entering through the min face.
+		if (entryTime > exitTime)
+		{
+			float swap = entryTime;
+			entryTime = exitTime;
+			exitTime = swap;
+			side = 1.0f;
+		}
+		if (entryTime > entry)
+		{
+			entry = entryTime;
+			normalX = axis == 0 ? side : 0.0f;
+			normalZ = axis == 1 ? side : 0.0f;
+		}
+		exit = std::fmin(exit, exitTime);
+		if (entry >= exit)
+		{
+			return noHit;
+		}
+	}
+	if (normalX == 0.0f && normalZ == 0.0f)
+	{
+		return noHit; //Only touches at the very start.
+	}
+	return { true, entry, normalX, normalZ };
+}
+
+SweepHit SweptCircleCircle(float startX, float startZ, float endX, float endZ, float carRad,
+	float sphereX, float sphereZ, float sphereRad)
+{
+	float radii = carRad + sphereRad;
+	float offX = startX - sphereX;
+	float offZ = startZ - sphereZ;
+	float moveX = endX - startX;
+	float moveZ = endZ - startZ;
+
+	//|off + move * t| = radii is a quadratic in t.
+	float c = offX * offX + offZ * offZ - radii * radii;
+	if (c < 0.0f)
+	{
+		//Already overlapping: push straight away from the centre.
+		float length = std::sqrt(offX*offX + offZ * offZ);
+		if (length == 0.0f)
+		{
+			return { true, 0.0f, 1.0f, 0.0f };
+		}
+		return { true, 0.0f, offX / length, offZ / length };
+	}
+
+	float a = moveX * moveX + moveZ * moveZ;
+	float b = offX * moveX + offZ * moveZ; //Half of the usual b.
+	if (a == 0.0f || b >= 0.0f)
+	{
+		return noHit; //Not moving, or moving away.
+	}
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f)
+	{
+		return noHit; //Passes to one side.
+	}
+	float time = (-b - std::sqrt(discriminant)) / a;
+	if (time > 1.0f)
+	{
+		return noHit; //Would touch after this frame.
+	}
+	float normalX = (offX + moveX * time) / radii;
+	float normalZ = (offZ + moveZ * time) / radii;
+	return { true, time, normalX, normalZ };
+}
@@ -0,0 +1,22 @@
+// Jonathan Walsh
+//Swept (continuous) collision tests.  car2Box and car2Sphere only look at where the car ends
+//the frame, so a fast car can jump straight over a thin wall.  These follow the car's whole
+//path for the frame and report how far along it the first touch happens.
+#pragma once
+
+struct SweepHit
+{
+	bool hit;
+	float time; //0 at the start of the move, 1 at the end.
+	float normalX; //Direction to push the car back out, pointing away from the obstacle.
+	float normalZ;
+};
+
+//Circle moving from start to end against an axis-aligned box, using the same box grown by the
+//car radius as car2Box.
+SweepHit SweptCircleBox(float startX, float startZ, float endX, float endZ, float carRad,
+	float boxX, float boxZ, float halfWidth, float halfDepth);
+
+//Circle moving from start to end against a still circle.
+SweepHit SweptCircleCircle(float startX, float startZ, float endX, float endZ, float carRad,
+	float sphereX, float sphereZ, float sphereRad);
@@ -0,0 +1,497 @@
+// Jonathan Walsh
+#include "TLRaceEngine.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+using namespace tle;
+
+namespace
+{
+	//Y coordinate of skybox.
+	const float skyYPos = -960.0f;
+
+	//The view the static models are culled against: the TL-Engine camera's field of view and
+	//window shape, out to the edge of the course.
+	const float cameraFov = 60.0f;
+	const float cameraAspect = 4.0f / 3.0f;
+	const float cullDistance = maxDistance;
+	const float unknownMeshRadius = 100.0f; //For a mesh whose bounds could not be read, big enough never to be culled wrongly.
+
+	//Every mesh the race uses, in MeshId order.
+	enum MeshId { CheckpointMesh, IsleMesh, WallMesh, CarMesh, FloorMesh, SkyMesh, DummyMesh, TankMesh, MeshCount };
+	const char* const meshFiles[MeshCount] = { "Checkpoint.x", "IsleStraight.x", "Wall.x", "race2.x", "ground.x", "Skybox 07.x", "dummy.x", "TankSmall1.x" };
+	const char* const mediaFolder = ".\\media";
+	const char* const meshCacheFolder = ".\\media\\cache";
+
+	//A sphere round the mesh's bounds, centred on the model's origin so it holds however the model is turned.
+	float MeshRadius(const MeshCache& cache, int mesh)
+	{
+		if (mesh >= cache.Count() || !cache.Error(mesh).empty())
+		{
+			return unknownMeshRadius;
+		}
+		const MeshView& view = cache.Mesh(mesh);
+		float sum = 0.0f;
+		for (int i = 0; i < 3; i++)
+		{
+			float furthest = std::max(std::fabs(view.boundsMin[i]), std::fabs(view.boundsMax[i]));
+			sum += furthest * furthest;
+		}
+		return std::sqrt(sum);
+	}
+
+	//Keyboard key mappings.
+	const EKeyCode quit = Key_Escape;
+	const EKeyCode accelForward = Key_W;
+	const EKeyCode decelBackward = Key_S;
+	const EKeyCode steerRight = Key_D;
+	const EKeyCode steerLeft = Key_A;
+	const EKeyCode cameraForward = Key_Up;
+	const EKeyCode cameraBackward = Key_Down;
+	const EKeyCode cameraRight = Key_Right;
+	const EKeyCode cameraLeft = Key_Left;
+	const EKeyCode chaseCamera = Key_1;
+	const EKeyCode fPCamera = Key_2;
+	const EKeyCode startOrBoost = Key_Space;
+	const int mouseMoveLimit = 32767; //Mouse movement is logged in 16 bits.
+
+#if RACE_PROFILE
+	const EKeyCode profileOverlay = Key_P;
+	const int profileRefreshFrames = 30; //The percentiles only need rebuilding a couple of times a second.
+	const int profileYPos = 100;
+	const int profileLineHeight = 24;
+#endif
+}
+
+TLRaceEngine::TLRaceEngine(const TrackData& track, const RaceSettings& settings, const GhostLap* ghostLap)
+{
+	// Create a 3D engine (using TLX engine here) and open a window for it
+	myEngine = New3DEngine(kTLX);
+	myEngine->StartWindowed();
+
+	// Add default folder for meshes and other media
+	myEngine->AddMediaFolder(mediaFolder);
+
+	//The meshes are parsed into the binary cache on every core at once, and only when a .x has changed.
+	ThreadPool loaders;
+	meshCache.Load(std::vector<std::string>(meshFiles, meshFiles + MeshCount), mediaFolder, meshCacheFolder, loaders);
+
+	float resetYPos = 10.0f;
+	float fPYPos = 5.0f;
+	float fPZPos = 5.0f;
+
+	string backDropImage = "ui_backdrop.jpg";
+	string aISkin = "sp01.jpg";
+	string ghostSkin = "sp02.jpg";
+
+	//Meshes.  The TL-Engine only loads meshes by file name, so it still reads the .x files itself.
+	IMesh*checkPointMesh = myEngine->LoadMesh(meshFiles[CheckpointMesh]);
+	IMesh*isleMesh = myEngine->LoadMesh(meshFiles[IsleMesh]);
+	IMesh*wallMesh = myEngine->LoadMesh(meshFiles[WallMesh]);
+	IMesh*carMesh = myEngine->LoadMesh(meshFiles[CarMesh]);
+	IMesh*floorMesh = myEngine->LoadMesh(meshFiles[FloorMesh]);
+	IMesh*skyMesh = myEngine->LoadMesh(meshFiles[SkyMesh]);
+	IMesh*dummyMesh = myEngine->LoadMesh(meshFiles[DummyMesh]);
+	IMesh*tankMesh = myEngine->LoadMesh(meshFiles[TankMesh]);
+
+	//Models
+	hoverCar = carMesh->CreateModel(0.0f, 0.0f, settings.initialCarZPos);
+	IModel* floor = floorMesh->CreateModel();
+	IModel* sky = skyMesh->CreateModel(0.0f, skyYPos, 0.0f);
+	dummyCar = dummyMesh->CreateModel();
+	resetCam = dummyMesh->CreateModel();
+	fPCam = dummyMesh->CreateModel();
+	backdrop = myEngine->CreateSprite(backDropImage);
+	myFont = myEngine->LoadFont("Verdana", 24);
+
+	//Camera Setup
+	myCamera = myEngine->CreateCamera(kManual);
+	myCamera->AttachToParent(dummyCar); //Camera attached to dummy car so then it follows the car and can rotate around the car.
+
+	dummyCar->AttachToParent(hoverCar);//Dummy is attached the the hover car.
+	resetCam->AttachToParent(dummyCar);//""
+	fPCam->AttachToParent(dummyCar);
+
+	resetCam->SetLocalZ(settings.initialCarZPos);//Camera is set to original position.
+	resetCam->SetLocalY(resetYPos); //Reset camera is elevated slightly off the ground.
+	fPCam->SetLocalY(fPYPos); //First person position relative to hover car.
+	fPCam->SetLocalZ(fPZPos);
+
+	hoverCarTransform = transforms.Add(0.0f, 0.0f, settings.initialCarZPos);
+	transformModels.push_back(hoverCar);
+	for (int i = 0; i < settings.aiCarCount; i++)
+	{
+		//The simulation places the AI cars, Present moves the models there on the first frame.
+		aICars.push_back(carMesh->CreateModel(settings.initialAiXPos, 0.0f, settings.initialCarZPos));
+		aICars[i]->SetSkin(aISkin); //Image being used on AI car,
+		aICarTransforms.push_back(transforms.Add(settings.initialAiXPos, 0.0f, settings.initialCarZPos));
+		transformModels.push_back(aICars[i]);
+	}
+	if (ghostLap != nullptr)
+	{
+		//The ghost starts on the player's spot, and drives through the other cars.
+		ghostCar = carMesh->CreateModel(0.0f, 0.0f, settings.initialCarZPos);
+		ghostCar->SetSkin(ghostSkin);
+		ghostCarTransform = transforms.Add(0.0f, 0.0f, settings.initialCarZPos);
+		transformModels.push_back(ghostCar);
+		ghost.Start(ghostLap);
+	}
+
+	//Every model that never moves goes in the culling tree, and is made and removed again as it comes
+	//into and goes out of view.
+	std::vector<float> cullX;
+	std::vector<float> cullY;
+	std::vector<float> cullZ;
+	std::vector<float> cullRadius;
+	auto addStatic = [&](IModel* model, IMesh* mesh, MeshId meshId, float x, float y, float z, float turnX, float turnY)
+	{
+		staticModels.push_back({ mesh, model, x, y, z, turnX, turnY });
+		cullX.push_back(x);
+		cullY.push_back(y);
+		cullZ.push_back(z);
+		cullRadius.push_back(MeshRadius(meshCache, meshId));
+	};
+	for (int i = 0; i < track.checkpointX.Count(); i++)
+	{
+		//Checkpoint models created, positioned and rotated.  Same with the next 4 for loops.
+		IModel* checkpoint = checkPointMesh->CreateModel(track.checkpointX[i], 0.0f, track.checkpointZ[i]);
+		checkpoint->RotateY(track.checkpointRotation[i]);
+		addStatic(checkpoint, checkPointMesh, CheckpointMesh, track.checkpointX[i], 0.0f, track.checkpointZ[i], 0.0f, track.checkpointRotation[i]);
+	}
+	for (int i = 0; i < track.isleX.Count(); i++)
+	{
+		IModel* isle = isleMesh->CreateModel(track.isleX[i], 0.0f, track.isleZ[i]);
+		addStatic(isle, isleMesh, IsleMesh, track.isleX[i], 0.0f, track.isleZ[i], 0.0f, 0.0f);
+	}
+	for (int i = 0; i < track.wallX.Count(); i++)
+	{
+		IModel* wall = wallMesh->CreateModel(track.wallX[i], 0.0f, track.wallZ[i]);
+		addStatic(wall, wallMesh, WallMesh, track.wallX[i], 0.0f, track.wallZ[i], 0.0f, 0.0f);
+	}
+	for (int i = 0; i < track.tankX.Count(); i++)
+	{
+		IModel* tank = tankMesh->CreateModel(track.tankX[i], track.tankY[i], track.tankZ[i]);
+		tank->RotateX(track.tankRotation[i]);
+		addStatic(tank, tankMesh, TankMesh, track.tankX[i], track.tankY[i], track.tankZ[i], track.tankRotation[i], 0.0f);
+	}
+	for (int i = 0; i < track.waypointX.Count(); i++)
+	{
+		IModel* waypoint = dummyMesh->CreateModel(track.waypointX[i], 0.0f, track.waypointZ[i]);
+		addStatic(waypoint, dummyMesh, DummyMesh, track.waypointX[i], 0.0f, track.waypointZ[i], 0.0f, 0.0f);
+	}
+	addStatic(floor, floorMesh, FloorMesh, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+	addStatic(sky, skyMesh, SkyMesh, 0.0f, skyYPos, 0.0f, 0.0f, 0.0f);
+	staticBvh.Build(cullX.data(), cullY.data(), cullZ.data(), cullRadius.data(), int(cullX.size()));
+	shownStatic.Reset(staticBvh.Count());
+	visibleStatic.reserve(staticBvh.Count());
+
+#if RACE_PROFILE
+	profiler.reset(new FrameProfiler());
+	FrameProfiler::Install(profiler.get());
+	for (int i = 0; i < PhaseCount; i++)
+	{
+		profileText[i].reserve(hudTextCapacity);
+	}
+#endif
+
+	myEngine->Timer(); // Timer initialised.
+}
+
+TLRaceEngine::~TLRaceEngine()
+{
+#if RACE_PROFILE
+	FrameProfiler::Install(nullptr);
+	profiler->ExportCsv("frame_profile.csv");
+#endif
+
+	// Delete the 3D engine now we are finished with it
+	myEngine->Delete();
+}
+
+bool TLRaceEngine::IsRunning()
+{
+	return myEngine->IsRunning();
+}
+
+float TLRaceEngine::Timer()
+{
+	return myEngine->Timer();
+}
+
+void TLRaceEngine::Stop()
+{
+	myEngine->Stop();
+}
+
+void TLRaceEngine::ReadInput(RaceInput& input)
+{
+	//Every key and the mouse are read once here, so the frame can be logged and replayed exactly.
+	const EKeyCode heldKeys[] = { accelForward, decelBackward, steerRight, steerLeft, startOrBoost, cameraForward, cameraBackward, cameraRight, cameraLeft };
+	const InputButton heldButtons[] = { AccelForward, DecelBackward, SteerRight, SteerLeft, BoostHeld, CameraForward, CameraBackward, CameraRight, CameraLeft };
+	for (int i = 0; i < int(sizeof(heldKeys) / sizeof(heldKeys[0])); i++)
+	{
+		input.Set(heldButtons[i], myEngine->KeyHeld(heldKeys[i]));
+	}
+	input.Set(StartHit, myEngine->KeyHit(startOrBoost));
+	input.Set(ChaseCameraHit, myEngine->KeyHit(chaseCamera));
+	input.Set(FirstPersonCameraHit, myEngine->KeyHit(fPCamera));
+
+	myEngine->StartMouseCapture();
+	input.mouseMoveX = int16_t(std::max(-mouseMoveLimit, std::min(mouseMoveLimit, myEngine->GetMouseMovementX())));
+	input.mouseMoveY = int16_t(std::max(-mouseMoveLimit, std::min(mouseMoveLimit, myEngine->GetMouseMovementY())));
+	frameInput = input;
+
+#if RACE_PROFILE
+	if (myEngine->KeyHit(profileOverlay))
+	{
+		showProfile = !showProfile;
+	}
+#endif
+
+	//Quit the game.
+	if (myEngine->KeyHit(quit))
+	{
+		myEngine->Stop();
+	}
+}
+
+void TLRaceEngine::Present(const RaceFrame& frame, float frameTime)
+{
+	//Move the models to where the simulation put the cars, part way between its last two ticks.
+	//Nothing reaches the engine until FlushTransforms.
+	const CarPose& player = frame.PlayerPose();
+	transforms.SetPosition(hoverCarTransform, player.x, 0.0f, player.z);
+	transforms.SetYaw(hoverCarTransform, player.yaw);
+
+	for (int i = 0; i < frame.AiCount(); i++)
+	{
+		const CarPose& ai = frame.AiPose(i);
+		transforms.SetPosition(aICarTransforms[i], ai.x, 0.0f, ai.z);
+		transforms.SetYaw(aICarTransforms[i], ai.yaw);
+	}
+	UpdateGhost(frame);
+	FlushTransforms();
+
+	{
+		PROFILE_SCOPE(PhaseCamera);
+		UpdateCamera(frameTime);
+	}
+	{
+		PROFILE_SCOPE(PhaseCulling);
+		CullStatic();
+	}
+	{
+		PROFILE_SCOPE(PhaseHud);
+		DrawHud(frame);
+#if RACE_PROFILE
+		DrawProfile();
+#endif
+	}
+
+	// Draw the scene
+	PROFILE_SCOPE(PhaseDrawScene);
+	myEngine->DrawScene();
+}
+
+void TLRaceEngine::UpdateGhost(const RaceFrame& frame)
+{
+	if (!ghost.Playing())
+	{
+		return;
+	}
+
+	//The ghost drives the same lap as the player, timed from when the player started it.
+	CarPose pose = ghost.Pose(frame.LapTime());
+	transforms.SetPosition(ghostCarTransform, pose.x, 0.0f, pose.z);
+	transforms.SetYaw(ghostCarTransform, pose.yaw);
+}
+
+void TLRaceEngine::CullStatic()
+{
+	//A model out of view is removed from its mesh, so DrawScene never sees it, and made again where it
+	//was when it comes back.  Only models that came into or went out of view since last frame are touched.
+	float matrix[16];
+	myCamera->GetMatrix(matrix);
+	ViewFrustum frustum = ViewFrustum::FromCamera(matrix, cameraFov, cameraAspect, 0.0f, cullDistance);
+	visibleStatic.clear();
+	staticBvh.Query(frustum, visibleStatic);
+	shownStatic.Update(visibleStatic, [this](int index, bool show)
+	{
+		StaticModel& item = staticModels[index];
+		if (show)
+		{
+			item.model = item.mesh->CreateModel(item.x, item.y, item.z);
+			if (item.turnX != 0.0f)
+			{
+				item.model->RotateX(item.turnX);
+			}
+			if (item.turnY != 0.0f)
+			{
+				item.model->RotateY(item.turnY);
+			}
+		}
+		else
+		{
+			item.mesh->RemoveModel(item.model);
+			item.model = nullptr;
+		}
+	});
+}
+
+void TLRaceEngine::FlushTransforms()
+{
+	//One position and one turn per changed model, however many changes were made to it this frame.
+	transforms.Flush([this](int model, bool moved, float x, float y, float z, float turn)
+	{
+		if (moved)
+		{
+			transformModels[model]->SetPosition(x, y, z);
+		}
+		if (turn != 0.0f)
+		{
+			transformModels[model]->RotateY(turn);
+		}
+	});
+}
+
+void TLRaceEngine::UpdateCamera(float frameTime)
+{
+	//The camera and its dummy are moved on the engine straight away, not through transforms: they
+	//move relative to their parents, pitch and reset their orientation, none of which the buffer
+	//keeps, and CullStatic reads the camera's matrix straight after.  It is at most one call per
+	//key or mouse axis a frame.
+
+	//Chase cam
+	//Keyboard input (cam move forward, backward, left, right)
+	float cameraSpeed = 10.0f;
+
+	if (frameInput.Held(CameraForward))
+	{
+		//Arrow up = move forward
+		myCamera->MoveZ(cameraSpeed*frameTime);
+	}
+	if (frameInput.Held(CameraBackward))
+	{
+		//Arrow down = move backward
+		myCamera->MoveZ(-cameraSpeed * frameTime);
+	}
+	if (frameInput.Held(CameraLeft))
+	{
+		//Arrow left = left movement
+		myCamera->MoveX(-cameraSpeed * frameTime);
+	}
+	if (frameInput.Held(CameraRight))
+	{
+		//Arrow right = right movement
+		myCamera->MoveX(cameraSpeed*frameTime);
+	}
+
+	//Mouse Input (cam rotate upwards, downwards, left and right relative to car)
+
+	//The mouse was read once in ReadInput, so a second read this frame would have been zero.
+	int mouseMoveX = frameInput.mouseMoveX;
+	int mouseMoveY = frameInput.mouseMoveY;
+	int yCamLimits = 250;
+	int xCamLimits = 2000;
+
+	if (mouseMoveX > 0 && limitX > -xCamLimits)
+	{
+		//Move mouse to the right. Camera rotates around hover car to the right.
+		dummyCar->RotateY(-cameraSpeed * frameTime*mouseMoveX);
+		limitX -= mouseMoveX;
+	}
+
+	if (mouseMoveX < 0 && limitX < xCamLimits)
+	{
+		//Move mouse to the left.  Camera rotates around hover car to the left.
+		if (mouseMoveX < 0)
+		{
+			mouseMoveX *= -1;
+		}
+		dummyCar->RotateY(cameraSpeed*frameTime *mouseMoveX);
+		limitX += mouseMoveX;
+	}
+
+	if (mouseMoveY > 0 && limitY < yCamLimits)
+	{
+		//Mouse moves downwards.
+		dummyCar->RotateLocalX(-cameraSpeed * frameTime*mouseMoveY);
+		limitY += mouseMoveY;
+	}
+	if (mouseMoveY < 0 && limitY > -yCamLimits)
+	{
+		//Mouse moves upwards.
+		if (mouseMoveY < 0)
+		{
+			int changeSign = -1;
+			mouseMoveY *= changeSign;
+		}
+		dummyCar->RotateLocalX(cameraSpeed*frameTime*mouseMoveY);
+		limitY -= mouseMoveY;
+	}
+	//Camera reset to third person view.
+	if (frameInput.Held(ChaseCameraHit))
+	{
+		myCamera->SetZ(resetCam->GetZ());
+		myCamera->SetX(resetCam->GetX());
+		myCamera->SetY(resetCam->GetY());
+		dummyCar->ResetOrientation();
+
+	}
+	//Camera reset to first person view.
+	if (frameInput.Held(FirstPersonCameraHit))
+	{
+		myCamera->SetZ(fPCam->GetZ());
+		myCamera->SetX(fPCam->GetX());
+		myCamera->SetY(fPCam->GetY());
+		dummyCar->ResetOrientation();
+	}
+}
+
+void TLRaceEngine::DrawHud(const RaceFrame& frame)
+{
+	//Text is only rebuilt when its value changes, so this is free of allocations frame to frame.
+	hud.Update(frame);
+	for (int i = 0; i < HudFieldCount; i++)
+	{
+		const HudField& field = hud.Field(i);
+		if (field.visible)
+		{
+			myFont->Draw(field.text, field.x, field.y);
+		}
+	}
+}
+
+#if RACE_PROFILE
+void TLRaceEngine::DrawProfile()
+{
+	if (!showProfile)
+	{
+		return;
+	}
+	if (profileRefresh-- <= 0)
+	{
+		profileRefresh = profileRefreshFrames;
+		PhaseStats stats[PhaseCount];
+		profiler->Stats(stats);
+		char number[hudTextCapacity];
+		for (int i = 0; i < PhaseCount; i++)
+		{
+			//"physics  p50 12.3  p95 20.1  p99 31.0 us"
+			std::string& text = profileText[i];
+			text = FrameProfiler::PhaseName(i);
+			text += "  p50 ";
+			text.append(number, FormatFixed(number, stats[i].p50, 1));
+			text += "  p95 ";
+			text.append(number, FormatFixed(number, stats[i].p95, 1));
+			text += "  p99 ";
+			text.append(number, FormatFixed(number, stats[i].p99, 1));
+			text += " us";
+		}
+	}
+	for (int i = 0; i < PhaseCount; i++)
+	{
+		myFont->Draw(profileText[i], 0, profileYPos + i * profileLineHeight);
+	}
+}
+#endif
@@ -0,0 +1,90 @@
+// Jonathan Walsh
+//TL-Engine backend.  Owns the window, the models, the cameras and the on screen text.
+#pragma once
+#include <TL-Engine.h>	// TL-Engine include file and namespace
+#include "RaceEngine.h"
+#include "RaceHud.h"
+#include "CullingBvh.h"
+#include "FrameProfiler.h"
+#include "GhostLap.h"
+#include "MeshCache.h"
+#include "TransformBuffer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class TLRaceEngine : public IRaceEngine
+{
+public:
+	TLRaceEngine(const TrackData& track, const RaceSettings& settings, const GhostLap* ghostLap = nullptr); //The ghost races alongside.
+	~TLRaceEngine();
+
+	bool IsRunning() override;
+	float Timer() override;
+	void ReadInput(RaceInput& input) override;
+	void Present(const RaceFrame& frame, float frameTime) override;
+	void Stop() override;
+
+private:
+	void UpdateGhost(const RaceFrame& frame);
+	void UpdateCamera(float frameTime);
+	void CullStatic();
+	void DrawHud(const RaceFrame& frame);
+	void FlushTransforms();
+#if RACE_PROFILE
+	void DrawProfile();
+#endif
+
+	tle::I3DEngine* myEngine;
+
+	//Models
+	tle::IModel* hoverCar;
+	std::vector<tle::IModel*> aICars;
+	tle::IModel* ghostCar = nullptr;
+	tle::IModel* dummyCar;
+	tle::IModel* resetCam;
+	tle::IModel* fPCam;
+	tle::ISprite* backdrop;
+	tle::IFont* myFont;
+	tle::ICamera* myCamera;
+	RaceHud hud;
+	MeshCache meshCache; //Vertices, triangles and bounds of every mesh, mapped from the binary cache.
+	RaceInput frameInput; //This frame's keys and mouse, read once in ReadInput.
+
+	//Where the car models are.  Moves go in here and reach the engine once per frame in FlushTransforms.
+	TransformBuffer transforms;
+	std::vector<tle::IModel*> transformModels; //The engine model for each transform handle.
+	int hoverCarTransform = 0;
+	std::vector<int> aICarTransforms;
+	int ghostCarTransform = 0;
+	GhostPlayer ghost;
+
+	//A model that never moves, and how to make it again after it has been out of view.
+	struct StaticModel
+	{
+		tle::IMesh* mesh;
+		tle::IModel* model; //nullptr while out of view.
+		float x;
+		float y;
+		float z;
+		float turnX;
+		float turnY;
+	};
+
+	//The models that never move, removed while the camera cannot see them.  Numbered the same in the tree and here.
+	CullingBvh staticBvh;
+	VisibleSet shownStatic;
+	std::vector<int> visibleStatic; //This frame's query.
+	std::vector<StaticModel> staticModels;
+
+	int limitX = 0; //The initial limit before mouse speed has been added on.  Same for below.
+	int limitY = 0;
+
+#if RACE_PROFILE
+	//Per-phase timings, shown on screen with P and written to frame_profile.csv on exit.
+	std::unique_ptr<FrameProfiler> profiler;
+	std::string profileText[PhaseCount];
+	bool showProfile = false;
+	int profileRefresh = 0; //Frames until the overlay text is rebuilt.
+#endif
+};
@@ -0,0 +1,194 @@
+// Jonathan Walsh
+#include "Telemetry.h"
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const size_t writeBatch = 4096; //Records taken off the ring and written at a time.
+	const std::chrono::milliseconds writerNap(1); //How long the writer sleeps when the ring is empty.
+	const float degreesToRadians = 3.14159265f / 180.0f;
+
+	static_assert(sizeof(TelemetryRecord) == 72, "Telemetry record layout changed");
+	static_assert(sizeof(TelemetryFileHeader) == 40, "Telemetry header layout changed");
+}
+
+TelemetryWriter::TelemetryWriter(size_t ringRecords)
+	: ring(ringRecords)
+{
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+	Close();
+}
+
+bool TelemetryWriter::Open(const std::string& path, const RaceSimulation& sim, std::string& error)
+{
+	Close();
+	file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+	memcpy(header.magic, telemetryMagic, sizeof(header.magic));
+	header.version = telemetryVersion;
+	header.recordSize = sizeof(TelemetryRecord);
+	header.carCount = uint32_t(sim.PlayerCount() + sim.Ai().Count());
+	header.tickRate = sim.Settings().tickRate;
+	fwrite(&header, sizeof(header), 1, file); //Rewritten with the counts on Close.
+
+	frame = 0;
+	dropped = 0;
+	written = 0;
+	writeFailed = false;
+	stopping = false;
+	writer = std::thread(&TelemetryWriter::WriterLoop, this);
+	return true;
+}
+
+void TelemetryWriter::Record(const RaceSimulation& sim)
+{
+	if (file == nullptr)
+	{
+		return;
+	}
+	PROFILE_SCOPE(PhaseTelemetry);
+	RaceState state = sim.State();
+	float raceTime = sim.RaceTime();
+	const AiCars& ai = sim.Ai();
+	const LapTracker& laps = sim.Laps();
+	int playerCount = sim.PlayerCount();
+	int count = std::min(playerCount + ai.Count(), int(header.carCount));
+
+	//Records are filled in straight on the ring, as much of the frame as there is room for at a time.
+	int car = 0;
+	while (car < count)
+	{
+		int room = int(ring.Reserve(count - car));
+		if (room == 0)
+		{
+			if (!waitWhenFull)
+			{
+				break;
+			}
+			std::this_thread::yield();
+			continue;
+		}
+		for (int i = 0; i < room; i++, car++)
+		{
+			TelemetryRecord& record = ring.Slot(i);
+			record.frame = frame;
+			record.car = uint32_t(car);
+			record.state = state;
+			record.raceTime = raceTime;
+			record.gatesPassed = laps.GatesPassed(car);
+			if (car < playerCount)
+			{
+				const CarState& player = sim.Player(car);
+				record.flags = laps.Finished(car) ? TelemetryFinished : 0;
+				record.x = player.x;
+				record.z = player.z;
+				record.headingX = std::sin(player.yaw * degreesToRadians);
+				record.headingZ = std::cos(player.yaw * degreesToRadians);
+				record.momentum = player.momentum;
+				record.thrust = player.thrust;
+				record.drag = player.drag;
+				record.boostDuration = player.boostDuration;
+				record.overheatDuration = player.overheatDuration;
+				record.health = int16_t(player.health);
+				record.collisions = uint16_t(player.collisions);
+			}
+			else
+			{
+				record.flags = TelemetryAi | (laps.Finished(car) ? TelemetryFinished : 0);
+				record.x = ai.x[car - playerCount];
+				record.z = ai.z[car - playerCount];
+				record.headingX = ai.headingX[car - playerCount];
+				record.headingZ = ai.headingZ[car - playerCount];
+				record.momentum = record.thrust = record.drag = { 0.0f, 0.0f };
+				record.boostDuration = record.overheatDuration = 0.0f;
+				record.health = 0;
+				record.collisions = 0;
+			}
+			record.padding = 0;
+		}
+		ring.Commit(room);
+	}
+	dropped += count - car;
+	frame++;
+}
+
+bool TelemetryWriter::Close()
+{
+	if (file == nullptr)
+	{
+		return true;
+	}
+	stopping.store(true, std::memory_order_release);
+	writer.join();
+
+	header.recordCount = written;
+	header.dropped = dropped;
+	bool ok = !writeFailed && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = fclose(file) == 0 && ok;
+	file = nullptr;
+	return ok;
+}
+
+void TelemetryWriter::WriterLoop()
+{
+	std::vector<TelemetryRecord> batch(writeBatch);
+	while (true)
+	{
+		//Everything pushed before the stop is on the ring by the time stopping reads true.
+		bool last = stopping.load(std::memory_order_acquire);
+		size_t taken = ring.PopMany(batch.data(), batch.size());
+		if (taken > 0)
+		{
+			writeFailed = fwrite(batch.data(), sizeof(TelemetryRecord), taken, file) != taken || writeFailed;
+			written += taken;
+		}
+		else if (last)
+		{
+			break;
+		}
+		else
+		{
+			std::this_thread::sleep_for(writerNap);
+		}
+	}
+}
+
+bool TelemetryFile::Open(const std::string& path, std::string& error)
+{
+	header = nullptr;
+	records = nullptr;
+	count = 0;
+	if (!file.Open(path, error))
+	{
+		return false;
+	}
+	const TelemetryFileHeader* fileHeader = reinterpret_cast<const TelemetryFileHeader*>(file.Data());
+	if (file.Size() < sizeof(TelemetryFileHeader) || memcmp(fileHeader->magic, telemetryMagic, sizeof(fileHeader->magic)) != 0)
+	{
+		error = path + ": not a telemetry file";
+		return false;
+	}
+	if (fileHeader->version != telemetryVersion || fileHeader->recordSize != sizeof(TelemetryRecord))
+	{
+		error = path + ": telemetry version " + std::to_string(fileHeader->version) + " is not supported";
+		return false;
+	}
+
+	//A file from a game that never closed it still reads, up to its last whole record.
+	uint64_t whole = (file.Size() - sizeof(TelemetryFileHeader)) / sizeof(TelemetryRecord);
+	header = fileHeader;
+	records = reinterpret_cast<const TelemetryRecord*>(file.Data() + sizeof(TelemetryFileHeader));
+	count = fileHeader->recordCount > 0 ? std::min(fileHeader->recordCount, whole) : whole;
+	return true;
+}
@@ -0,0 +1,114 @@
+// Jonathan Walsh
+//Per-frame car telemetry for looking at races afterwards.  The game thread copies every car's
+//state into fixed-size records and pushes them onto a lock-free ring; a background thread takes
+//them off in batches and writes them to a binary .rtel file, so the game thread never waits on
+//the disk.  If the writer falls behind, records are dropped and counted rather than stalling a
+//frame.  TelemetryReader prints or converts the files.
+#pragma once
+#include "MappedFile.h"
+#include "RaceSimulation.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+const char telemetryMagic[4] = { 'R', 'T', 'E', 'L' };
+const uint32_t telemetryVersion = 2;
+const size_t telemetryRingRecords = 1 << 16;
+
+struct TelemetryFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t recordSize; //sizeof(TelemetryRecord).
+	uint32_t carCount; //Records per frame.  The players come first, then the AI cars.
+	float tickRate;
+	uint32_t padding;
+	uint64_t recordCount; //Filled in when the file is closed.
+	uint64_t dropped; //Records lost because the writer fell behind.
+};
+
+enum TelemetryFlag : uint8_t
+{
+	TelemetryAi = 1, //Only the position, heading and gates are filled in.
+	TelemetryFinished = 2,
+};
+
+struct TelemetryRecord
+{
+	uint32_t frame;
+	uint32_t car;
+	uint8_t state; //RaceState.
+	uint8_t flags; //TelemetryFlag bits.
+	int16_t health;
+	float x;
+	float z;
+	float headingX; //Unit facing vector, so no angle has to be worked out on the game thread.
+	float headingZ;
+	vector2D momentum;
+	vector2D thrust;
+	vector2D drag;
+	float boostDuration;
+	float overheatDuration;
+	uint16_t collisions;
+	uint16_t padding;
+	float raceTime;
+	int32_t gatesPassed;
+};
+
+class TelemetryWriter
+{
+public:
+	explicit TelemetryWriter(size_t ringRecords = telemetryRingRecords);
+	~TelemetryWriter();
+
+	TelemetryWriter(const TelemetryWriter&) = delete;
+	TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+	bool Open(const std::string& path, const RaceSimulation& sim, std::string& error);
+	bool IsOpen() const { return file != nullptr; }
+
+	//Game thread.  Pushes a record for every car.
+	void Record(const RaceSimulation& sim);
+
+	//Keeps every record by waiting for room when the game thread can afford to (headless runs).
+	//Otherwise records that do not fit on a full ring are dropped.
+	void WaitWhenFull(bool wait) { waitWhenFull = wait; }
+
+	//Writes what is left, fills in the header and closes the file.  False if anything failed to write.
+	bool Close();
+	uint64_t Dropped() const { return dropped; }
+
+private:
+	void WriterLoop();
+
+	SpscRing<TelemetryRecord> ring;
+	std::thread writer;
+	std::atomic<bool> stopping{ false };
+	FILE* file = nullptr;
+	TelemetryFileHeader header = {};
+	uint32_t frame = 0;
+	uint64_t dropped = 0;
+	uint64_t written = 0; //Writer thread only until it has been joined.
+	bool writeFailed = false;
+	bool waitWhenFull = false;
+};
+
+//A telemetry file mapped read-only into memory.
+class TelemetryFile
+{
+public:
+	bool Open(const std::string& path, std::string& error);
+	const TelemetryFileHeader& Header() const { return *header; }
+	const TelemetryRecord* Records() const { return records; }
+	uint64_t Count() const { return count; }
+
+private:
+	MappedFile file;
+	const TelemetryFileHeader* header = nullptr;
+	const TelemetryRecord* records = nullptr;
+	uint64_t count = 0;
+};
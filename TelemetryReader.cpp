@@ -0,0 +1,139 @@
+// Jonathan Walsh
+//Reads the .rtel telemetry files written by the game or HeadlessRace --telemetry.
+//    TelemetryReader race.rtel                  prints a summary of every car
+//    TelemetryReader race.rtel --csv out.csv    writes every record as CSV
+//    --car N limits either to one car (the players come first, then the AI cars).
+#include "Telemetry.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	const int summaryCars = 16; //Cars listed in the summary before the rest are counted together.
+	const float radiansToDegrees = 180.0f / 3.14159265f;
+
+	bool WriteCsv(const TelemetryFile& telemetry, const char* path, int onlyCar)
+	{
+		FILE* file = fopen(path, "w");
+		if (file == nullptr)
+		{
+			return false;
+		}
+		fprintf(file, "frame,car,state,flags,x,z,yaw,momentum_x,momentum_z,thrust_x,thrust_z,drag_x,drag_z,boost,overheat,health,collisions,race_time,gates\n");
+		for (uint64_t i = 0; i < telemetry.Count(); i++)
+		{
+			const TelemetryRecord& r = telemetry.Records()[i];
+			if (onlyCar >= 0 && r.car != uint32_t(onlyCar))
+			{
+				continue;
+			}
+			fprintf(file, "%u,%u,%u,%u,%.3f,%.3f,%.2f,%.4f,%.4f,%.4f,%.4f,%.5f,%.5f,%.3f,%.3f,%d,%u,%.3f,%d\n",
+				r.frame, r.car, r.state, r.flags, r.x, r.z, std::atan2(r.headingX, r.headingZ) * radiansToDegrees, r.momentum.x, r.momentum.z, r.thrust.x, r.thrust.z,
+				r.drag.x, r.drag.z, r.boostDuration, r.overheatDuration, r.health, r.collisions, r.raceTime, r.gatesPassed);
+		}
+		return fclose(file) == 0;
+	}
+
+	void PrintSummary(const TelemetryFile& telemetry, int onlyCar)
+	{
+		const TelemetryFileHeader& header = telemetry.Header();
+		uint32_t cars = std::max(header.carCount, 1u);
+		printf("cars: %u\n", header.carCount);
+		printf("frames: %llu\n", (unsigned long long)(telemetry.Count() / cars));
+		printf("tick rate: %.0f Hz\n", header.tickRate);
+		printf("records: %llu, dropped: %llu\n", (unsigned long long)telemetry.Count(), (unsigned long long)header.dropped);
+
+		//Last record, top speed and lowest health of every car.
+		std::vector<const TelemetryRecord*> last(cars, nullptr);
+		std::vector<float> topSpeed(cars, 0.0f);
+		std::vector<int> lowestHealth(cars, 0);
+		for (uint64_t i = 0; i < telemetry.Count(); i++)
+		{
+			const TelemetryRecord& r = telemetry.Records()[i];
+			if (r.car >= cars)
+			{
+				continue;
+			}
+			topSpeed[r.car] = std::max(topSpeed[r.car], std::sqrt(r.momentum.x * r.momentum.x + r.momentum.z * r.momentum.z));
+			lowestHealth[r.car] = last[r.car] == nullptr ? r.health : std::min(lowestHealth[r.car], int(r.health));
+			last[r.car] = &r;
+		}
+
+		int finished = 0;
+		for (uint32_t car = 0; car < cars; car++)
+		{
+			const TelemetryRecord* r = last[car];
+			if (r == nullptr || (onlyCar >= 0 && int(car) != onlyCar))
+			{
+				continue;
+			}
+			finished += (r->flags & TelemetryFinished) != 0;
+			if (car >= uint32_t(summaryCars) && onlyCar < 0)
+			{
+				continue;
+			}
+			if ((r->flags & TelemetryAi) != 0)
+			{
+				printf("car %u (ai): at %.1f, %.1f, gates %d%s\n", car, r->x, r->z, r->gatesPassed, (r->flags & TelemetryFinished) != 0 ? ", finished" : "");
+			}
+			else
+			{
+				printf("car %u (player): at %.1f, %.1f, gates %d%s, top momentum %.2f, lowest health %d, collisions %u\n", car, r->x, r->z,
+					r->gatesPassed, (r->flags & TelemetryFinished) != 0 ? ", finished" : "", topSpeed[car], lowestHealth[car], r->collisions);
+			}
+		}
+		if (onlyCar < 0 && cars > uint32_t(summaryCars))
+		{
+			printf("... %u more cars\n", cars - summaryCars);
+		}
+		printf("finished: %d\n", finished);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* csvPath = nullptr;
+	int onlyCar = -1;
+	bool usage = argc < 2;
+	for (int i = 2; i < argc && !usage; i++)
+	{
+		if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+		{
+			csvPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--car") == 0 && i + 1 < argc)
+		{
+			onlyCar = atoi(argv[++i]);
+		}
+		else
+		{
+			usage = true;
+		}
+	}
+	if (usage)
+	{
+		printf("Usage: %s race.rtel [--csv out.csv] [--car N]\n", argv[0]);
+		return 1;
+	}
+
+	TelemetryFile telemetry;
+	std::string error;
+	if (!telemetry.Open(argv[1], error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	if (csvPath != nullptr)
+	{
+		if (!WriteCsv(telemetry, csvPath, onlyCar))
+		{
+			fprintf(stderr, "Could not write %s\n", csvPath);
+			return 1;
+		}
+		return 0;
+	}
+	PrintSummary(telemetry, onlyCar);
+	return 0;
+}
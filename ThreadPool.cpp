@@ -0,0 +1,130 @@
+// Jonathan Walsh
+#include "ThreadPool.h"
+
+namespace
+{
+	//The pool whose worker is running on this thread and that worker's index, null and -1 for other threads.
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local int currentWorker = -1;
+}
+
+ThreadPool::ThreadPool(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = int(std::thread::hardware_concurrency());
+		if (threadCount <= 0)
+		{
+			threadCount = 1;
+		}
+	}
+
+	for (int i = 0; i < threadCount; i++)
+	{
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	WaitIdle();
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+void ThreadPool::Submit(Task task)
+{
+	//Tasks made by one of this pool's workers stay on its own queue, everything else is dealt out
+	//round robin, including tasks a worker of another pool hands to this one.
+	int index = currentPool == this ? currentWorker : -1;
+	if (index < 0)
+	{
+		index = int(nextQueue++ % queues.size());
+	}
+
+	pending++;
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		queued++;
+	}
+	wakeWorkers.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+	std::unique_lock<std::mutex> guard(sleepLock);
+	allDone.wait(guard, [this] { return pending == 0; });
+}
+
+bool ThreadPool::PopOwn(int index, Task& task)
+{
+	std::lock_guard<std::mutex> guard(queues[index]->lock);
+	if (queues[index]->tasks.empty())
+	{
+		return false;
+	}
+	task = std::move(queues[index]->tasks.back()); //Newest first, its data is most likely still in cache.
+	queues[index]->tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::Steal(int thief, Task& task)
+{
+	int count = int(queues.size());
+	for (int offset = 1; offset < count; offset++)
+	{
+		WorkQueue& victim = *queues[(thief + offset) % count];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front()); //Oldest first, away from the owner's end.
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+	currentPool = this;
+	currentWorker = index;
+	for (;;)
+	{
+		Task task;
+		if (PopOwn(index, task) || Steal(index, task))
+		{
+			queued--;
+			task();
+			if (--pending == 0)
+			{
+				std::lock_guard<std::mutex> guard(sleepLock);
+				allDone.notify_all();
+			}
+			continue;
+		}
+
+		//Nothing to do anywhere, sleep until a task is submitted.
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wakeWorkers.wait(guard, [this] { return stopping || queued > 0; });
+		if (stopping && queued == 0)
+		{
+			return;
+		}
+	}
+}
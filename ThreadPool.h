@@ -0,0 +1,67 @@
+// Jonathan Walsh
+//Work-stealing thread pool.  Every worker has its own queue; it takes its newest task first
+//and, when its queue runs dry, steals the oldest task from another worker.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	explicit ThreadPool(int threadCount = 0); //0 uses one thread per core.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(Task task);
+	void WaitIdle(); //Blocks until every submitted task has finished.
+	int ThreadCount() const { return int(workers.size()); }
+
+	//Runs job(0) to job(count - 1), the last on the calling thread and the rest on the pool, and
+	//returns once they have all finished.  Waits for the whole pool, so it is for a pool nothing
+	//else is using, and never from inside one of its own tasks.
+	template <class Job>
+	void RunJobs(int count, const Job& job)
+	{
+		for (int i = 0; i < count - 1; i++)
+		{
+			Submit([&job, i] { job(i); });
+		}
+		if (count > 0)
+		{
+			job(count - 1);
+		}
+		WaitIdle();
+	}
+
+private:
+	struct WorkQueue
+	{
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	void WorkerLoop(int index);
+	bool PopOwn(int index, Task& task);
+	bool Steal(int thief, Task& task);
+
+	std::vector<std::unique_ptr<WorkQueue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepLock; //Guards sleeping and waking, not the queues.
+	std::condition_variable wakeWorkers;
+	std::condition_variable allDone;
+	std::atomic<int> queued{ 0 }; //Tasks sitting in a queue.
+	std::atomic<int> pending{ 0 }; //Tasks submitted but not finished.
+	std::atomic<unsigned> nextQueue{ 0 };
+	bool stopping = false;
+};
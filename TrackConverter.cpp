@@ -0,0 +1,199 @@
+// Jonathan Walsh
+//Converts a text track into the binary .htrk file the game maps at startup.
+//    TrackConverter input.txt output.htrk [--cell-size N]
+//    TrackConverter --default output.txt    writes the original course out as text
+//    TrackConverter --generate output.htrk|output.txt [--seed N] [--obstacles N] [--checkpoints N] [--cell-size N]
+//                                           writes a generated test track, see TrackGenerator.h
+//    TrackConverter --meshes media [cache]   brings the binary cache of every .x in media up to date
+//    TrackConverter --mesh-check             parses a small mesh written the ways exporters write it
+#include "MeshCache.h"
+#include "TrackFile.h"
+#include "TrackGenerator.h"
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	bool EndsWith(const char* text, const char* ending)
+	{
+		size_t textLength = strlen(text);
+		size_t endingLength = strlen(ending);
+		return textLength >= endingLength && strcmp(text + textLength - endingLength, ending) == 0;
+	}
+
+	//Writes a baked track and says what went in it.
+	int WriteBaked(const char* path, const BakedTrack& baked)
+	{
+		std::string error;
+		if (!WriteTrackFile(path, baked, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		printf("%s: %d checkpoints, %d walls, %d struts, %d tanks, %d waypoints\n", path, baked.Data().checkpointX.count,
+			baked.Data().walls.count, baked.Data().struts.count, baked.Data().tanks.count, baked.Data().waypointX.count);
+		return 0;
+	}
+
+	int Generate(int argc, char* argv[])
+	{
+		TrackGeneratorOptions options;
+		float cellSize = defaultCellSize;
+		for (int i = 3; i + 1 < argc; i += 2)
+		{
+			if (strcmp(argv[i], "--seed") == 0) options.seed = unsigned(strtoul(argv[i + 1], nullptr, 10));
+			else if (strcmp(argv[i], "--obstacles") == 0) options.obstacles = atoi(argv[i + 1]);
+			else if (strcmp(argv[i], "--checkpoints") == 0) options.checkpoints = atoi(argv[i + 1]);
+			else if (strcmp(argv[i], "--cell-size") == 0) cellSize = float(atof(argv[i + 1]));
+			else
+			{
+				fprintf(stderr, "unknown option %s\n", argv[i]);
+				return 1;
+			}
+		}
+		if ((argc - 3) % 2 != 0 || options.obstacles < 0 || options.checkpoints < 1 || !(cellSize > 0.0f))
+		{
+			fprintf(stderr, "bad --generate options\n");
+			return 1;
+		}
+
+		RaceTrack track = GenerateTrack(options);
+		std::string error;
+		if (EndsWith(argv[2], ".txt"))
+		{
+			if (!SaveTrackText(argv[2], track, error))
+			{
+				fprintf(stderr, "%s\n", error.c_str());
+				return 1;
+			}
+			return 0;
+		}
+		return WriteBaked(argv[2], BakedTrack(track, cellSize));
+	}
+
+	//One quad, on its own, after the templates it uses and inside a frame.  Each must read back the same.
+	int CheckMeshParser()
+	{
+		const std::string header = "xof 0303txt 0032\n";
+		const std::string mesh =
+			"Mesh quad {\n 4;\n 0.0;0.0;0.0;,\n 1.0;0.0;0.0;,\n 1.0;0.0;1.0;,\n 0.0;0.0;1.0;;\n 1;\n 4;0,1,2,3;;\n}\n";
+		const std::string templates =
+			"template Vector {\n <3d82ab5e-62da-11cf-ab39-0020af71e433>\n FLOAT x;\n FLOAT y;\n FLOAT z;\n}\n"
+			"template Mesh {\n <3d82ab44-62da-11cf-ab39-0020af71e433>\n DWORD nVertices;\n array Vector vertices[nVertices];\n"
+			" DWORD nFaces;\n array MeshFace faces[nFaces];\n [...]\n}\n";
+		const std::string frame = "Frame root {\n FrameTransformMatrix {\n 1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0,0.0,0.0,0.0,0.0,1.0;;\n }\n";
+		const char* names[] = { "plain", "after templates", "inside a frame" };
+		const std::string texts[] = { header + mesh, header + templates + mesh, header + templates + frame + mesh + "}\n" };
+
+		int failures = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			MeshData parsed;
+			std::string error;
+			if (!ParseXMesh(texts[i], parsed, error))
+			{
+				printf("%s: %s\n", names[i], error.c_str());
+				failures++;
+			}
+			else if (parsed.vertices.size() != 4 || parsed.indices.size() != 6 || parsed.boundsMax[0] != 1.0f || parsed.boundsMax[2] != 1.0f)
+			{
+				printf("%s: read %d vertices and %d triangles, not 4 and 2\n", names[i], int(parsed.vertices.size()), int(parsed.indices.size() / 3));
+				failures++;
+			}
+			else
+			{
+				printf("%s: ok\n", names[i]);
+			}
+		}
+		return failures == 0 ? 0 : 1;
+	}
+
+	int BuildMeshCache(const std::string& mediaFolder, const std::string& cacheFolder)
+	{
+		std::vector<std::string> names;
+		std::error_code failed;
+		for (std::filesystem::directory_iterator entry(mediaFolder, failed), end; !failed && entry != end; entry.increment(failed))
+		{
+			if (entry->path().extension() == ".x")
+			{
+				names.push_back(entry->path().filename().string());
+			}
+		}
+		if (failed)
+		{
+			fprintf(stderr, "cannot read %s\n", mediaFolder.c_str());
+			return 1;
+		}
+
+		ThreadPool pool;
+		MeshCache cache;
+		bool ok = cache.Load(names, mediaFolder, cacheFolder, pool);
+		for (int i = 0; i < cache.Count(); i++)
+		{
+			if (!cache.Error(i).empty())
+			{
+				fprintf(stderr, "%s\n", cache.Error(i).c_str());
+				continue;
+			}
+			printf("%s: %d vertices, %d triangles, %s\n", names[i].c_str(), cache.Mesh(i).vertexCount, cache.Mesh(i).indexCount / 3,
+				cache.Rebuilt(i) ? "rebuilt" : "up to date");
+		}
+		return ok ? 0 : 1;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string error;
+	if (argc >= 3 && strcmp(argv[1], "--generate") == 0)
+	{
+		return Generate(argc, argv);
+	}
+	if ((argc == 3 || argc == 4) && strcmp(argv[1], "--meshes") == 0)
+	{
+		return BuildMeshCache(argv[2], argc == 4 ? argv[3] : (std::filesystem::path(argv[2]) / "cache").string());
+	}
+	if (argc == 2 && strcmp(argv[1], "--mesh-check") == 0)
+	{
+		return CheckMeshParser();
+	}
+	if (argc == 3 && strcmp(argv[1], "--default") == 0)
+	{
+		if (!SaveTrackText(argv[2], DefaultTrack(), error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		return 0;
+	}
+
+	float cellSize = defaultCellSize;
+	if (argc == 5 && strcmp(argv[3], "--cell-size") == 0)
+	{
+		cellSize = float(atof(argv[4]));
+	}
+	else if (argc != 3)
+	{
+		printf("Usage: %s input.txt output.htrk [--cell-size N]\n", argv[0]);
+		printf("       %s --default output.txt\n", argv[0]);
+		printf("       %s --generate output.htrk|output.txt [--seed N] [--obstacles N] [--checkpoints N] [--cell-size N]\n", argv[0]);
+		printf("       %s --meshes media [cache]\n", argv[0]);
+		printf("       %s --mesh-check\n", argv[0]);
+		return 1;
+	}
+	if (!(cellSize > 0.0f))
+	{
+		fprintf(stderr, "cell size must be above 0\n");
+		return 1;
+	}
+
+	RaceTrack track;
+	if (!LoadTrackText(argv[1], track, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	return WriteBaked(argv[2], BakedTrack(track, cellSize));
+}
@@ -0,0 +1,55 @@
+// Jonathan Walsh
+#include "TrackData.h"
+
+namespace
+{
+	TrackArray ArrayOf(const std::vector<float>& values)
+	{
+		return { values.data(), int(values.size()) };
+	}
+}
+
+BakedTrack::BakedTrack(const RaceTrack& track, float cellSize)
+	: source(track)
+{
+	for (size_t i = 0; i < source.wallX.size(); i++)
+	{
+		walls.Add(source.wallX[i], source.wallZ[i], wallWidth, wallDepth);
+	}
+	for (size_t i = 0; i < source.strutX.size(); i++)
+	{
+		struts.Add(source.strutX[i], source.strutZ[i], strutRad);
+	}
+	for (size_t i = 0; i < source.tankX.size(); i++)
+	{
+		tanks.Add(source.tankX[i], source.tankZ[i], tankRad);
+	}
+	BuildGrid(walls, wallGrid, cellSize);
+	BuildGrid(struts, strutGrid, cellSize);
+	BuildGrid(tanks, tankGrid, cellSize);
+	racingLine.Build(source.waypointX.data(), source.waypointZ.data(), int(source.waypointX.size()));
+
+	data.checkpointX = ArrayOf(source.checkpointX);
+	data.checkpointZ = ArrayOf(source.checkpointZ);
+	data.checkpointRotation = ArrayOf(source.checkpointRotation);
+	data.strutX = ArrayOf(source.strutX);
+	data.strutZ = ArrayOf(source.strutZ);
+	data.isleX = ArrayOf(source.isleX);
+	data.isleZ = ArrayOf(source.isleZ);
+	data.wallX = ArrayOf(source.wallX);
+	data.wallZ = ArrayOf(source.wallZ);
+	data.tankX = ArrayOf(source.tankX);
+	data.tankY = ArrayOf(source.tankY);
+	data.tankZ = ArrayOf(source.tankZ);
+	data.tankRotation = ArrayOf(source.tankRotation);
+	data.waypointX = ArrayOf(source.waypointX);
+	data.waypointZ = ArrayOf(source.waypointZ);
+
+	data.walls = walls.View();
+	data.struts = struts.View();
+	data.tanks = tanks.View();
+	data.wallGrid = wallGrid.View();
+	data.strutGrid = strutGrid.View();
+	data.tankGrid = tankGrid.View();
+	data.racingLine = racingLine.View();
+}
@@ -0,0 +1,77 @@
+// Jonathan Walsh
+//The read-only form of a track the game runs on.  Every array is a pointer and a count, so the
+//same TrackData can point at a BakedTrack built in memory or at a track file mapped from disk.
+#pragma once
+#include "RaceTrack.h"
+#include "RacingLine.h"
+#include "SpatialGrid.h"
+
+struct TrackArray
+{
+	const float* data;
+	int count;
+
+	float operator[](int i) const { return data[i]; }
+	int Count() const { return count; }
+};
+
+struct TrackData
+{
+	//Where the models go, in the order the track lists them.
+	TrackArray checkpointX;
+	TrackArray checkpointZ;
+	TrackArray checkpointRotation;
+	TrackArray strutX;
+	TrackArray strutZ;
+	TrackArray isleX;
+	TrackArray isleZ;
+	TrackArray wallX;
+	TrackArray wallZ;
+	TrackArray tankX;
+	TrackArray tankY;
+	TrackArray tankZ;
+	TrackArray tankRotation;
+	TrackArray waypointX;
+	TrackArray waypointZ;
+
+	//Collision obstacles, sorted into the order of their broadphase grids.
+	BoxObstacleView walls;
+	SphereObstacleView struts;
+	SphereObstacleView tanks;
+	GridView wallGrid;
+	GridView strutGrid;
+	GridView tankGrid;
+
+	RacingLineView racingLine; //The waypoints baked into the line the AI cars drive.
+};
+
+//Builds the collision stores and grids for a RaceTrack and owns them.
+class BakedTrack
+{
+public:
+	explicit BakedTrack(const RaceTrack& track, float cellSize = defaultCellSize);
+
+	BakedTrack(const BakedTrack&) = delete; //TrackData points into this object.
+	BakedTrack& operator=(const BakedTrack&) = delete;
+
+	const TrackData& Data() const { return data; }
+	const RaceTrack& Source() const { return source; }
+	const BoxObstacles& Walls() const { return walls; }
+	const SphereObstacles& Struts() const { return struts; }
+	const SphereObstacles& Tanks() const { return tanks; }
+	const SpatialGrid& WallGrid() const { return wallGrid; }
+	const SpatialGrid& StrutGrid() const { return strutGrid; }
+	const SpatialGrid& TankGrid() const { return tankGrid; }
+	const RacingLine& Line() const { return racingLine; }
+
+private:
+	RaceTrack source;
+	BoxObstacles walls;
+	SphereObstacles struts;
+	SphereObstacles tanks;
+	SpatialGrid wallGrid;
+	SpatialGrid strutGrid;
+	SpatialGrid tankGrid;
+	RacingLine racingLine;
+	TrackData data;
+};
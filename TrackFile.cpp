@@ -0,0 +1,499 @@
+// Jonathan Walsh
+#include "TrackFile.h"
+#include "CompiledTrack.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	const uint64_t sectionAlignment = 16; //Sections are written on 16 bytes, but Bind only needs 4: the SIMD kernels use unaligned loads.
+
+	static_assert(sizeof(TrackFileHeader) == 16, "Track file header layout changed");
+	static_assert(sizeof(TrackFileSection) == 16, "Track file section layout changed");
+	static_assert(sizeof(GridParams) == 24, "Grid parameters layout changed");
+	static_assert(sizeof(RacingLineParams) == 16, "Racing line parameters layout changed");
+
+	//Sections waiting to be written: where the bytes are and how many elements they hold.
+	struct PendingSection
+	{
+		uint32_t id;
+		uint32_t count;
+		const void* bytes;
+		size_t byteCount;
+	};
+
+	void AddFloats(std::vector<PendingSection>& sections, uint32_t id, const std::vector<float>& values)
+	{
+		sections.push_back({ id, uint32_t(values.size()), values.data(), values.size() * sizeof(float) });
+	}
+
+	void AddGrid(std::vector<PendingSection>& sections, uint32_t gridId, uint32_t cellsId, const SpatialGrid& grid)
+	{
+		sections.push_back({ gridId, 1, &grid.Params(), sizeof(GridParams) });
+		sections.push_back({ cellsId, uint32_t(grid.CellStarts().size()), grid.CellStarts().data(), grid.CellStarts().size() * sizeof(int) });
+	}
+
+	bool ReadFloats(std::istringstream& line, float* values, int required, int optional)
+	{
+		for (int i = 0; i < required + optional; i++)
+		{
+			if (!(line >> values[i]))
+			{
+				if (i < required)
+				{
+					return false;
+				}
+				values[i] = 0.0f;
+				line.clear();
+			}
+		}
+		return true;
+	}
+}
+
+bool LoadTrackText(const std::string& path, RaceTrack& track, std::string& error)
+{
+	std::ifstream file(path.c_str());
+	if (!file)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+
+	track = RaceTrack();
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(file, text))
+	{
+		lineNumber++;
+		std::istringstream line(text);
+		std::string kind;
+		if (!(line >> kind) || kind[0] == '#')
+		{
+			continue; //Blank line or comment.
+		}
+
+		float values[4];
+		bool ok = false;
+		if (kind == "checkpoint" && (ok = ReadFloats(line, values, 2, 1)))
+		{
+			track.checkpointX.push_back(values[0]);
+			track.checkpointZ.push_back(values[1]);
+			track.checkpointRotation.push_back(values[2]);
+		}
+		else if (kind == "strut" && (ok = ReadFloats(line, values, 2, 0)))
+		{
+			track.strutX.push_back(values[0]);
+			track.strutZ.push_back(values[1]);
+		}
+		else if (kind == "isle" && (ok = ReadFloats(line, values, 2, 0)))
+		{
+			track.isleX.push_back(values[0]);
+			track.isleZ.push_back(values[1]);
+		}
+		else if (kind == "wall" && (ok = ReadFloats(line, values, 2, 0)))
+		{
+			track.wallX.push_back(values[0]);
+			track.wallZ.push_back(values[1]);
+		}
+		else if (kind == "tank" && (ok = ReadFloats(line, values, 3, 1)))
+		{
+			track.tankX.push_back(values[0]);
+			track.tankY.push_back(values[1]);
+			track.tankZ.push_back(values[2]);
+			track.tankRotation.push_back(values[3]);
+		}
+		else if (kind == "waypoint" && (ok = ReadFloats(line, values, 2, 0)))
+		{
+			track.waypointX.push_back(values[0]);
+			track.waypointZ.push_back(values[1]);
+		}
+
+		if (!ok)
+		{
+			error = path + ":" + std::to_string(lineNumber) + ": cannot read \"" + text + "\"";
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SaveTrackText(const std::string& path, const RaceTrack& track, std::string& error)
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+
+	fprintf(file, "# checkpoint x z [rotation]\n");
+	for (size_t i = 0; i < track.checkpointX.size(); i++)
+	{
+		fprintf(file, "checkpoint %g %g %g\n", track.checkpointX[i], track.checkpointZ[i], track.checkpointRotation[i]);
+	}
+	fprintf(file, "# strut x z\n");
+	for (size_t i = 0; i < track.strutX.size(); i++)
+	{
+		fprintf(file, "strut %g %g\n", track.strutX[i], track.strutZ[i]);
+	}
+	fprintf(file, "# isle x z\n");
+	for (size_t i = 0; i < track.isleX.size(); i++)
+	{
+		fprintf(file, "isle %g %g\n", track.isleX[i], track.isleZ[i]);
+	}
+	fprintf(file, "# wall x z\n");
+	for (size_t i = 0; i < track.wallX.size(); i++)
+	{
+		fprintf(file, "wall %g %g\n", track.wallX[i], track.wallZ[i]);
+	}
+	fprintf(file, "# tank x y z [rotation]\n");
+	for (size_t i = 0; i < track.tankX.size(); i++)
+	{
+		fprintf(file, "tank %g %g %g %g\n", track.tankX[i], track.tankY[i], track.tankZ[i], track.tankRotation[i]);
+	}
+	fprintf(file, "# waypoint x z\n");
+	for (size_t i = 0; i < track.waypointX.size(); i++)
+	{
+		fprintf(file, "waypoint %g %g\n", track.waypointX[i], track.waypointZ[i]);
+	}
+
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+	{
+		error = "cannot write " + path;
+	}
+	return ok;
+}
+
+bool WriteTrackFile(const std::string& path, const BakedTrack& track, std::string& error)
+{
+	const RaceTrack& source = track.Source();
+	std::vector<PendingSection> sections;
+	AddFloats(sections, SectionCheckpointX, source.checkpointX);
+	AddFloats(sections, SectionCheckpointZ, source.checkpointZ);
+	AddFloats(sections, SectionCheckpointRotation, source.checkpointRotation);
+	AddFloats(sections, SectionStrutX, source.strutX);
+	AddFloats(sections, SectionStrutZ, source.strutZ);
+	AddFloats(sections, SectionIsleX, source.isleX);
+	AddFloats(sections, SectionIsleZ, source.isleZ);
+	AddFloats(sections, SectionWallX, source.wallX);
+	AddFloats(sections, SectionWallZ, source.wallZ);
+	AddFloats(sections, SectionTankX, source.tankX);
+	AddFloats(sections, SectionTankY, source.tankY);
+	AddFloats(sections, SectionTankZ, source.tankZ);
+	AddFloats(sections, SectionTankRotation, source.tankRotation);
+	AddFloats(sections, SectionWaypointX, source.waypointX);
+	AddFloats(sections, SectionWaypointZ, source.waypointZ);
+
+	AddFloats(sections, SectionWallBoxX, track.Walls().x);
+	AddFloats(sections, SectionWallBoxZ, track.Walls().z);
+	AddFloats(sections, SectionWallHalfWidth, track.Walls().halfWidth);
+	AddFloats(sections, SectionWallHalfDepth, track.Walls().halfDepth);
+	AddGrid(sections, SectionWallGrid, SectionWallCells, track.WallGrid());
+	AddFloats(sections, SectionStrutSphereX, track.Struts().x);
+	AddFloats(sections, SectionStrutSphereZ, track.Struts().z);
+	AddFloats(sections, SectionStrutRadius, track.Struts().radius);
+	AddGrid(sections, SectionStrutGrid, SectionStrutCells, track.StrutGrid());
+	AddFloats(sections, SectionTankSphereX, track.Tanks().x);
+	AddFloats(sections, SectionTankSphereZ, track.Tanks().z);
+	AddFloats(sections, SectionTankRadius, track.Tanks().radius);
+	AddGrid(sections, SectionTankGrid, SectionTankCells, track.TankGrid());
+	sections.push_back({ SectionLineParams, 1, &track.Line().Params(), sizeof(RacingLineParams) });
+	AddFloats(sections, SectionLineX, track.Line().x);
+	AddFloats(sections, SectionLineZ, track.Line().z);
+	AddFloats(sections, SectionLineHeadingX, track.Line().headingX);
+	AddFloats(sections, SectionLineHeadingZ, track.Line().headingZ);
+	AddFloats(sections, SectionLineSpeed, track.Line().speed);
+	AddFloats(sections, SectionWallMinX, track.Walls().minX);
+	AddFloats(sections, SectionWallMaxX, track.Walls().maxX);
+	AddFloats(sections, SectionWallMinZ, track.Walls().minZ);
+	AddFloats(sections, SectionWallMaxZ, track.Walls().maxZ);
+	AddFloats(sections, SectionStrutTouchSq, track.Struts().touchSq);
+	AddFloats(sections, SectionTankTouchSq, track.Tanks().touchSq);
+
+	//Header, section table, then each section's data on an aligned offset.
+	TrackFileHeader header;
+	memcpy(header.magic, trackFileMagic, sizeof(header.magic));
+	header.version = trackFileVersion;
+	header.byteOrder = trackFileByteOrder;
+	header.sectionCount = uint32_t(sections.size());
+
+	std::vector<TrackFileSection> table(sections.size());
+	uint64_t offset = sizeof(header) + sizeof(TrackFileSection) * table.size();
+	for (size_t i = 0; i < sections.size(); i++)
+	{
+		offset = (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+		table[i].id = sections[i].id;
+		table[i].count = sections[i].count;
+		table[i].offset = offset;
+		offset += sections[i].byteCount;
+	}
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		error = "cannot write " + path;
+		return false;
+	}
+	const char padding[sectionAlignment] = {};
+	uint64_t written = 0;
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(table.data(), sizeof(TrackFileSection), table.size(), file);
+	written = sizeof(header) + sizeof(TrackFileSection) * table.size();
+	for (size_t i = 0; i < sections.size(); i++)
+	{
+		fwrite(padding, 1, size_t(table[i].offset - written), file);
+		if (sections[i].byteCount > 0)
+		{
+			fwrite(sections[i].bytes, 1, sections[i].byteCount, file);
+		}
+		written = table[i].offset + sections[i].byteCount;
+	}
+
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+	{
+		error = "cannot write " + path;
+	}
+	return ok;
+}
+
+bool MappedTrack::Open(const std::string& path, std::string& error)
+{
+	Close();
+	if (!file.Open(path, error))
+	{
+		return false;
+	}
+	if (!Bind(error))
+	{
+		Close();
+		error = path + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+void MappedTrack::Close()
+{
+	file.Close();
+	data = TrackData();
+}
+
+bool MappedTrack::Bind(std::string& error)
+{
+	const unsigned char* base = file.Data();
+	size_t size = file.Size();
+	if (size < sizeof(TrackFileHeader))
+	{
+		error = "too small to be a track file";
+		return false;
+	}
+	const TrackFileHeader* header = reinterpret_cast<const TrackFileHeader*>(base);
+	if (memcmp(header->magic, trackFileMagic, sizeof(header->magic)) != 0)
+	{
+		error = "not a track file";
+		return false;
+	}
+	if (header->version != trackFileVersion || header->byteOrder != trackFileByteOrder)
+	{
+		error = "track file version " + std::to_string(header->version) + " is not supported, rebuild it with TrackConverter";
+		return false;
+	}
+	if (header->sectionCount > (size - sizeof(TrackFileHeader)) / sizeof(TrackFileSection))
+	{
+		error = "section table is cut short";
+		return false;
+	}
+
+	//Find each section once and check it lies inside the file.
+	const TrackFileSection* table = reinterpret_cast<const TrackFileSection*>(base + sizeof(TrackFileHeader));
+	const TrackFileSection* found[SectionIdEnd] = {};
+	for (uint32_t i = 0; i < header->sectionCount; i++)
+	{
+		const TrackFileSection& section = table[i];
+		if (section.id > 0 && section.id < SectionIdEnd)
+		{
+			bool grid = section.id == SectionWallGrid || section.id == SectionStrutGrid || section.id == SectionTankGrid;
+			uint64_t elementSize = grid ? sizeof(GridParams) : (section.id == SectionLineParams ? sizeof(RacingLineParams) : 4);
+			if (section.offset % 4 != 0 || section.offset > size || uint64_t(section.count) * elementSize > size - section.offset)
+			{
+				error = "section " + std::to_string(section.id) + " runs past the end of the file";
+				return false;
+			}
+			found[section.id] = &section;
+		}
+	}
+	for (int id = 1; id < SectionIdEnd; id++)
+	{
+		if (found[id] == nullptr)
+		{
+			error = "section " + std::to_string(id) + " is missing";
+			return false;
+		}
+	}
+
+	auto floats = [&](int id) -> TrackArray
+	{
+		return { reinterpret_cast<const float*>(base + found[id]->offset), int(found[id]->count) };
+	};
+	auto grid = [&](int gridId, int cellsId, int obstacleCount, GridView& view) -> bool
+	{
+		if (found[gridId]->count != 1)
+		{
+			return false;
+		}
+		view.params = *reinterpret_cast<const GridParams*>(base + found[gridId]->offset);
+		view.cellStart = reinterpret_cast<const int*>(base + found[cellsId]->offset);
+		const GridParams& params = view.params;
+		if (params.cellsX < 0 || params.cellsZ < 0 || !(params.cellSize > 0.0f) || !std::isfinite(params.cellSize))
+		{
+			return false;
+		}
+		if (!std::isfinite(params.originX) || !std::isfinite(params.originZ) || !(params.reach >= 0.0f) || !std::isfinite(params.reach))
+		{
+			return false;
+		}
+		uint64_t cells = uint64_t(params.cellsX) * uint64_t(params.cellsZ);
+		if (cells == 0)
+		{
+			view.cellStart = nullptr;
+			return obstacleCount == 0;
+		}
+		if (found[cellsId]->count != cells + 1 || view.cellStart[0] != 0 || view.cellStart[cells] != obstacleCount)
+		{
+			return false;
+		}
+		for (uint64_t c = 0; c < cells; c++)
+		{
+			if (view.cellStart[c] > view.cellStart[c + 1])
+			{
+				return false; //Ranges must never run backwards or past the store.
+			}
+		}
+		return true;
+	};
+
+	data.checkpointX = floats(SectionCheckpointX);
+	data.checkpointZ = floats(SectionCheckpointZ);
+	data.checkpointRotation = floats(SectionCheckpointRotation);
+	data.strutX = floats(SectionStrutX);
+	data.strutZ = floats(SectionStrutZ);
+	data.isleX = floats(SectionIsleX);
+	data.isleZ = floats(SectionIsleZ);
+	data.wallX = floats(SectionWallX);
+	data.wallZ = floats(SectionWallZ);
+	data.tankX = floats(SectionTankX);
+	data.tankY = floats(SectionTankY);
+	data.tankZ = floats(SectionTankZ);
+	data.tankRotation = floats(SectionTankRotation);
+	data.waypointX = floats(SectionWaypointX);
+	data.waypointZ = floats(SectionWaypointZ);
+
+	TrackArray wallBoxX = floats(SectionWallBoxX);
+	data.walls = { wallBoxX.data, floats(SectionWallBoxZ).data, floats(SectionWallHalfWidth).data, floats(SectionWallHalfDepth).data,
+		floats(SectionWallMinX).data, floats(SectionWallMaxX).data, floats(SectionWallMinZ).data, floats(SectionWallMaxZ).data, wallBoxX.count };
+	TrackArray strutSphereX = floats(SectionStrutSphereX);
+	data.struts = { strutSphereX.data, floats(SectionStrutSphereZ).data, floats(SectionStrutRadius).data, floats(SectionStrutTouchSq).data, strutSphereX.count };
+	TrackArray tankSphereX = floats(SectionTankSphereX);
+	data.tanks = { tankSphereX.data, floats(SectionTankSphereZ).data, floats(SectionTankRadius).data, floats(SectionTankTouchSq).data, tankSphereX.count };
+	if (found[SectionLineParams]->count != 1)
+	{
+		error = "racing line is damaged";
+		return false;
+	}
+	data.racingLine.params = *reinterpret_cast<const RacingLineParams*>(base + found[SectionLineParams]->offset);
+	data.racingLine.x = floats(SectionLineX).data;
+	data.racingLine.z = floats(SectionLineZ).data;
+	data.racingLine.headingX = floats(SectionLineHeadingX).data;
+	data.racingLine.headingZ = floats(SectionLineHeadingZ).data;
+	data.racingLine.speed = floats(SectionLineSpeed).data;
+	const RacingLineParams& line = data.racingLine.params;
+
+	//Arrays that are read side by side must be the same length.
+	bool matching =
+		data.checkpointZ.count == data.checkpointX.count && data.checkpointRotation.count == data.checkpointX.count &&
+		data.strutZ.count == data.strutX.count && data.isleZ.count == data.isleX.count && data.wallZ.count == data.wallX.count &&
+		data.tankY.count == data.tankX.count && data.tankZ.count == data.tankX.count && data.tankRotation.count == data.tankX.count &&
+		data.waypointZ.count == data.waypointX.count &&
+		int(found[SectionWallBoxZ]->count) == data.walls.count && int(found[SectionWallHalfWidth]->count) == data.walls.count &&
+		int(found[SectionWallHalfDepth]->count) == data.walls.count &&
+		int(found[SectionWallMinX]->count) == data.walls.count && int(found[SectionWallMaxX]->count) == data.walls.count &&
+		int(found[SectionWallMinZ]->count) == data.walls.count && int(found[SectionWallMaxZ]->count) == data.walls.count &&
+		int(found[SectionStrutSphereZ]->count) == data.struts.count && int(found[SectionStrutRadius]->count) == data.struts.count &&
+		int(found[SectionStrutTouchSq]->count) == data.struts.count &&
+		int(found[SectionTankSphereZ]->count) == data.tanks.count && int(found[SectionTankRadius]->count) == data.tanks.count &&
+		int(found[SectionTankTouchSq]->count) == data.tanks.count &&
+		line.count >= 0 && int(found[SectionLineX]->count) == line.count && int(found[SectionLineZ]->count) == line.count &&
+		int(found[SectionLineHeadingX]->count) == line.count && int(found[SectionLineHeadingZ]->count) == line.count &&
+		int(found[SectionLineSpeed]->count) == line.count;
+	if (!matching)
+	{
+		error = "array lengths do not match";
+		return false;
+	}
+	if (line.count > 0 && !(line.spacing > 0.0f && line.openLength >= 0.0f && line.openLength <= line.loopLength && int(line.openLength / line.spacing) < line.count))
+	{
+		error = "racing line is damaged";
+		return false;
+	}
+	if (!grid(SectionWallGrid, SectionWallCells, data.walls.count, data.wallGrid) ||
+		!grid(SectionStrutGrid, SectionStrutCells, data.struts.count, data.strutGrid) ||
+		!grid(SectionTankGrid, SectionTankCells, data.tanks.count, data.tankGrid))
+	{
+		error = "broadphase grid is damaged";
+		return false;
+	}
+	return true;
+}
+
+bool LoadedTrack::Load(const std::string& path, std::string& error)
+{
+	baked.reset();
+	mapped.Close();
+	compiled = nullptr;
+
+	const std::string binaryExtension = ".htrk";
+	if (path.size() >= binaryExtension.size() && path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0)
+	{
+		return mapped.Open(path, error);
+	}
+
+	RaceTrack track;
+	if (!LoadTrackText(path, track, error))
+	{
+		return false;
+	}
+	baked.reset(new BakedTrack(track));
+	return true;
+}
+
+void LoadedTrack::Bake(const RaceTrack& track)
+{
+	mapped.Close();
+	compiled = nullptr;
+	baked.reset(new BakedTrack(track));
+}
+
+void LoadedTrack::LoadDefault()
+{
+	baked.reset();
+	mapped.Close();
+	compiled = &CompiledDefaultTrack();
+}
+
+const TrackData& LoadedTrack::Data() const
+{
+	if (compiled != nullptr)
+	{
+		return *compiled;
+	}
+	return baked ? baked->Data() : mapped.Data();
+}
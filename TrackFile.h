@@ -0,0 +1,95 @@
+// Jonathan Walsh
+//Track files.  Tracks are written by hand as text (see tracks/Default.txt) and converted by
+//TrackConverter into a binary .htrk file.  The binary file holds every array the game needs,
+//including the sorted collision stores and broadphase grids, at 16 byte aligned offsets, so it
+//is mapped into memory and used where it lies: no parsing and no allocation per object.
+#pragma once
+#include "MappedFile.h"
+#include "TrackData.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+const char trackFileMagic[4] = { 'H', 'T', 'R', 'K' };
+const uint32_t trackFileVersion = 3;
+const uint32_t trackFileByteOrder = 0x01020304; //Reads back differently on a machine with the other byte order.
+
+enum TrackSectionId
+{
+	SectionCheckpointX = 1, SectionCheckpointZ, SectionCheckpointRotation,
+	SectionStrutX, SectionStrutZ,
+	SectionIsleX, SectionIsleZ,
+	SectionWallX, SectionWallZ,
+	SectionTankX, SectionTankY, SectionTankZ, SectionTankRotation,
+	SectionWaypointX, SectionWaypointZ,
+
+	//Collision stores in grid order, and the grids themselves.
+	SectionWallBoxX, SectionWallBoxZ, SectionWallHalfWidth, SectionWallHalfDepth, SectionWallGrid, SectionWallCells,
+	SectionStrutSphereX, SectionStrutSphereZ, SectionStrutRadius, SectionStrutGrid, SectionStrutCells,
+	SectionTankSphereX, SectionTankSphereZ, SectionTankRadius, SectionTankGrid, SectionTankCells,
+
+	//The AI racing line.
+	SectionLineParams, SectionLineX, SectionLineZ, SectionLineHeadingX, SectionLineHeadingZ, SectionLineSpeed,
+
+	//The collision stores grown by the car's radius, in the same order.
+	SectionWallMinX, SectionWallMaxX, SectionWallMinZ, SectionWallMaxZ, SectionStrutTouchSq, SectionTankTouchSq,
+
+	SectionIdEnd
+};
+
+struct TrackFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t sectionCount; //A table of this many TrackFileSections follows the header.
+};
+
+struct TrackFileSection
+{
+	uint32_t id; //A TrackSectionId.
+	uint32_t count; //Number of elements, not bytes.
+	uint64_t offset; //From the start of the file.
+};
+
+//Text track source.  One object per line: "checkpoint x z [rotation]", "strut x z", "isle x z",
+//"wall x z", "tank x y z [rotation]" or "waypoint x z".  Lines starting with # are comments.
+bool LoadTrackText(const std::string& path, RaceTrack& track, std::string& error);
+bool SaveTrackText(const std::string& path, const RaceTrack& track, std::string& error);
+
+bool WriteTrackFile(const std::string& path, const BakedTrack& track, std::string& error);
+
+//A binary track file mapped read-only into memory.  The TrackData points straight into the mapping.
+class MappedTrack
+{
+public:
+	MappedTrack() {}
+
+	MappedTrack(const MappedTrack&) = delete;
+	MappedTrack& operator=(const MappedTrack&) = delete;
+
+	bool Open(const std::string& path, std::string& error);
+	void Close();
+	const TrackData& Data() const { return data; }
+
+private:
+	bool Bind(std::string& error); //Checks the file and points the TrackData at its sections.
+
+	MappedFile file;
+	TrackData data = {};
+};
+
+//Loads a track from a .htrk file (mapped) or a text file (parsed and baked).
+class LoadedTrack
+{
+public:
+	bool Load(const std::string& path, std::string& error);
+	void Bake(const RaceTrack& track); //Uses a track built in memory instead.
+	void LoadDefault(); //Uses the default track compiled into the program.
+	const TrackData& Data() const;
+
+private:
+	std::unique_ptr<BakedTrack> baked;
+	MappedTrack mapped;
+	const TrackData* compiled = nullptr;
+};
@@ -0,0 +1,193 @@
+// Jonathan Walsh
+#include "TrackGenerator.h"
+#include "RacePhysics.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const float pi = 3.14159265f;
+	const float radiansToDegrees = 180.0f / pi;
+	const float sampleSpacing = 2.0f; //Length between centre line samples.
+	const float strutOffset = 8.5f; //Either side of a gate's centre, as on the original course.
+	const int isleEvery = 6; //One edge piece in this many is an isle, the rest are walls.
+
+	struct CentreLine
+	{
+		std::vector<float> x;
+		std::vector<float> z;
+		std::vector<float> headingX; //Unit direction of travel.
+		std::vector<float> headingZ;
+	};
+
+	//Point on a closed Catmull-Rom curve through the control points, segment i at t from 0 to 1.
+	void CurvePoint(const std::vector<float>& px, const std::vector<float>& pz, int i, float t, float& x, float& z)
+	{
+		int n = int(px.size());
+		int a = (i + n - 1) % n;
+		int b = i;
+		int c = (i + 1) % n;
+		int d = (i + 2) % n;
+		float t2 = t * t;
+		float t3 = t2 * t;
+		x = 0.5f * (2 * px[b] + (px[c] - px[a]) * t + (2 * px[a] - 5 * px[b] + 4 * px[c] - px[d]) * t2 + (3 * px[b] - px[a] - 3 * px[c] + px[d]) * t3);
+		z = 0.5f * (2 * pz[b] + (pz[c] - pz[a]) * t + (2 * pz[a] - 5 * pz[b] + 4 * pz[c] - pz[d]) * t2 + (3 * pz[b] - pz[a] - 3 * pz[c] + pz[d]) * t3);
+	}
+
+	//A wobbly circle of the given length, sampled every sampleSpacing along it.
+	CentreLine MakeCentreLine(float length, float wobble, std::mt19937& random)
+	{
+		float radius = length / (2 * pi);
+		int controlCount = std::max(8, std::min(64, int(length / 200.0f)));
+		std::uniform_real_distribution<float> jitter(1.0f - wobble / 2, 1.0f + wobble / 2);
+		std::vector<float> px(controlCount), pz(controlCount);
+		for (int i = 0; i < controlCount; i++)
+		{
+			float angle = 2 * pi * i / controlCount;
+			float r = radius * jitter(random);
+			px[i] = std::cos(angle) * r;
+			pz[i] = std::sin(angle) * r;
+		}
+
+		//Sample finely, then keep points sampleSpacing apart along the curve.
+		CentreLine line;
+		int steps = std::max(16, int(length / controlCount)); //About one step per unit.
+		float lastX = 0.0f, lastZ = 0.0f, travelled = 0.0f;
+		CurvePoint(px, pz, 0, 0.0f, lastX, lastZ);
+		line.x.push_back(lastX);
+		line.z.push_back(lastZ);
+		for (int i = 0; i < controlCount; i++)
+		{
+			for (int s = 1; s <= steps; s++)
+			{
+				float x, z;
+				CurvePoint(px, pz, i, float(s) / steps, x, z);
+				travelled += std::sqrt((x - lastX) * (x - lastX) + (z - lastZ) * (z - lastZ));
+				lastX = x;
+				lastZ = z;
+				if (travelled >= sampleSpacing)
+				{
+					travelled = 0.0f;
+					line.x.push_back(x);
+					line.z.push_back(z);
+				}
+			}
+		}
+		line.x.pop_back(); //The loop is closed, so the last sample is the first one again.
+		line.z.pop_back();
+
+		int count = int(line.x.size());
+		line.headingX.resize(count);
+		line.headingZ.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			int next = (i + 1) % count;
+			int previous = (i + count - 1) % count;
+			float dx = line.x[next] - line.x[previous];
+			float dz = line.z[next] - line.z[previous];
+			float d = std::sqrt(dx*dx + dz * dz);
+			line.headingX[i] = d > 0.0f ? dx / d : 0.0f;
+			line.headingZ[i] = d > 0.0f ? dz / d : 1.0f;
+		}
+		return line;
+	}
+
+	//Turns and moves the line so sample 0 sits at (0, -runUp) heading along +Z.
+	void PlaceStart(CentreLine& line, float runUp)
+	{
+		float cosA = line.headingZ[0];
+		float sinA = line.headingX[0];
+		float originX = line.x[0];
+		float originZ = line.z[0];
+		for (size_t i = 0; i < line.x.size(); i++)
+		{
+			float x = line.x[i] - originX;
+			float z = line.z[i] - originZ;
+			line.x[i] = x * cosA - z * sinA;
+			line.z[i] = x * sinA + z * cosA - runUp;
+			float hx = line.headingX[i];
+			float hz = line.headingZ[i];
+			line.headingX[i] = hx * cosA - hz * sinA;
+			line.headingZ[i] = hx * sinA + hz * cosA;
+		}
+	}
+}
+
+RaceTrack GenerateTrack(const TrackGeneratorOptions& options)
+{
+	std::mt19937 random(options.seed);
+	RaceTrack track;
+
+	//Two edges of walls, so the walls decide the length.
+	int tanks = int(options.obstacles * options.tankShare);
+	int edgePieces = std::max(options.obstacles - tanks, 64);
+	float length = std::max(edgePieces / 2 * options.wallSpacing, float(options.checkpoints) * 60.0f);
+	CentreLine line = MakeCentreLine(length, options.wobble, random);
+	PlaceStart(line, options.startRunUp);
+	int samples = int(line.x.size());
+
+	//Gates evenly spaced from the end of the run up, the last just before the start line.
+	int runUpSamples = int(options.startRunUp / sampleSpacing);
+	for (int i = 0; i < options.checkpoints; i++)
+	{
+		int s = (runUpSamples + i * (samples - runUpSamples) / options.checkpoints) % samples;
+		float hx = line.headingX[s];
+		float hz = line.headingZ[s];
+		track.checkpointX.push_back(line.x[s]);
+		track.checkpointZ.push_back(line.z[s]);
+		track.checkpointRotation.push_back(std::atan2(hx, hz) * radiansToDegrees);
+
+		//Struts on the gate's local X, which is (hz, -hx) when its local Z is the heading.
+		track.strutX.push_back(line.x[s] - hz * strutOffset);
+		track.strutZ.push_back(line.z[s] + hx * strutOffset);
+		track.strutX.push_back(line.x[s] + hz * strutOffset);
+		track.strutZ.push_back(line.z[s] - hx * strutOffset);
+	}
+
+	//Edge pieces down both sides at even spacing.
+	int stride = std::max(1, int(options.wallSpacing / sampleSpacing));
+	int piece = 0;
+	for (int s = 0; s < samples; s += stride)
+	{
+		for (int side = -1; side <= 1; side += 2)
+		{
+			float x = line.x[s] + line.headingZ[s] * options.roadHalfWidth * side;
+			float z = line.z[s] - line.headingX[s] * options.roadHalfWidth * side;
+			if (piece++ % isleEvery == 0)
+			{
+				track.isleX.push_back(x);
+				track.isleZ.push_back(z);
+			}
+			else
+			{
+				track.wallX.push_back(x);
+				track.wallZ.push_back(z);
+			}
+		}
+	}
+
+	//Tanks off the road, somewhere between just past the walls and twice as far out.
+	std::uniform_int_distribution<int> anySample(0, samples - 1);
+	std::uniform_real_distribution<float> offset(options.roadHalfWidth + wallDepth, options.roadHalfWidth * 2 + wallDepth);
+	std::uniform_int_distribution<int> anySide(0, 1);
+	for (int i = 0; i < tanks; i++)
+	{
+		int s = anySample(random);
+		float side = anySide(random) == 0 ? -1.0f : 1.0f;
+		float away = offset(random) * side;
+		track.tankX.push_back(line.x[s] + line.headingZ[s] * away);
+		track.tankY.push_back(0.0f);
+		track.tankZ.push_back(line.z[s] - line.headingX[s] * away);
+		track.tankRotation.push_back(0.0f);
+	}
+
+	//Waypoints all the way round the centre line, starting past the run up.
+	int waypointStride = std::max(1, int(options.waypointSpacing / sampleSpacing));
+	for (int s = runUpSamples; s < samples + runUpSamples; s += waypointStride)
+	{
+		track.waypointX.push_back(line.x[s % samples]);
+		track.waypointZ.push_back(line.z[s % samples]);
+	}
+	return track;
+}
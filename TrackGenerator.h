@@ -0,0 +1,22 @@
+// Jonathan Walsh
+//Seeded generator for big test tracks.  Lays out a closed circuit with gates along it, struts on
+//each gate, walls and isles down both edges, tanks scattered either side and an AI waypoint loop.
+//The same options and seed always give the same track.  The start line is placed so the cars'
+//usual starting spots (RaceSettings) sit on the track, heading up +Z into the first gate.
+#pragma once
+#include "RaceTrack.h"
+
+struct TrackGeneratorOptions
+{
+	unsigned seed = 1;
+	int obstacles = 1000; //Roughly how many walls and tanks; sets the length of the circuit.
+	int checkpoints = 16;
+	float tankShare = 0.1f; //Part of the obstacles that are tanks, the rest are walls.
+	float roadHalfWidth = 20.0f; //Centre line to the walls.
+	float wallSpacing = 8.0f; //Along each edge.
+	float waypointSpacing = 20.0f;
+	float wobble = 0.3f; //How far the circuit strays from a circle, as a share of its radius.
+	float startRunUp = 30.0f; //Track before the first gate, where the cars line up.
+};
+
+RaceTrack GenerateTrack(const TrackGeneratorOptions& options);
@@ -0,0 +1,70 @@
+// Jonathan Walsh
+#include "TransformBuffer.h"
+#include <cmath>
+
+int TransformBuffer::Add(float newX, float newY, float newZ, float newYaw)
+{
+	x.push_back(newX);
+	y.push_back(newY);
+	z.push_back(newZ);
+	yaw.push_back(newYaw);
+	appliedYaw.push_back(newYaw);
+	flags.push_back(0);
+	if (dirty.capacity() < x.size())
+	{
+		dirty.reserve(x.capacity()); //Grows with x, so every model changing in one frame never needs to allocate.
+	}
+	return int(x.size()) - 1;
+}
+
+void TransformBuffer::MarkDirty(int model, uint8_t flag)
+{
+	if (flags[model] == 0)
+	{
+		dirty.push_back(model);
+	}
+	flags[model] |= flag;
+}
+
+void TransformBuffer::SetPosition(int model, float newX, float newY, float newZ)
+{
+	if (x[model] == newX && y[model] == newY && z[model] == newZ)
+	{
+		return;
+	}
+	x[model] = newX;
+	y[model] = newY;
+	z[model] = newZ;
+	MarkDirty(model, Moved);
+}
+
+void TransformBuffer::Move(int model, float dx, float dy, float dz)
+{
+	SetPosition(model, x[model] + dx, y[model] + dy, z[model] + dz);
+}
+
+void TransformBuffer::SetYaw(int model, float degrees)
+{
+	if (yaw[model] == degrees)
+	{
+		return;
+	}
+	yaw[model] = degrees;
+	MarkDirty(model, Turned);
+}
+
+void TransformBuffer::RotateY(int model, float degrees)
+{
+	SetYaw(model, yaw[model] + degrees);
+}
+
+void TransformBuffer::FaceTowards(int model, float targetX, float targetZ)
+{
+	const float radiansToDegrees = 180.0f / 3.14159265f;
+	float dx = targetX - x[model];
+	float dz = targetZ - z[model];
+	if (dx != 0.0f || dz != 0.0f)
+	{
+		SetYaw(model, std::atan2(dx, dz) * radiansToDegrees);
+	}
+}
@@ -0,0 +1,57 @@
+// Jonathan Walsh
+//A mirror of where each engine model is, and the changes waiting to be sent to it.  Moves and
+//turns are written here during the frame, reads come from here instead of the engine, and
+//Flush hands each changed model to the engine once, with its final position and the whole
+//turn for the frame, just before DrawScene.  Models that did not change are not touched.  The
+//camera and its dummy are not in here; see TLRaceEngine::UpdateCamera.
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class TransformBuffer
+{
+public:
+	//Registers a model placed at (x, y, z) and turned yaw degrees, and returns its handle.
+	int Add(float x, float y, float z, float yaw = 0.0f);
+	int Count() const { return int(x.size()); }
+
+	void SetPosition(int model, float newX, float newY, float newZ);
+	void Move(int model, float dx, float dy, float dz);
+	void SetYaw(int model, float degrees);
+	void RotateY(int model, float degrees);
+	void FaceTowards(int model, float targetX, float targetZ); //LookAt on level ground.
+
+	float X(int model) const { return x[model]; }
+	float Y(int model) const { return y[model]; }
+	float Z(int model) const { return z[model]; }
+	float Yaw(int model) const { return yaw[model]; }
+	int Pending() const { return int(dirty.size()); } //Models waiting to be flushed.
+
+	//Calls apply(model, moved, x, y, z, turn) once for every model changed since the last flush,
+	//where turn is the yaw change still to be applied to the engine model.
+	template <class Apply>
+	void Flush(Apply apply)
+	{
+		for (int model : dirty)
+		{
+			float turn = yaw[model] - appliedYaw[model];
+			apply(model, (flags[model] & Moved) != 0, x[model], y[model], z[model], turn);
+			appliedYaw[model] = yaw[model];
+			flags[model] = 0;
+		}
+		dirty.clear();
+	}
+
+private:
+	enum Flag : uint8_t { Moved = 1, Turned = 2 };
+
+	void MarkDirty(int model, uint8_t flag);
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> yaw;
+	std::vector<float> appliedYaw; //The yaw the engine model has now.
+	std::vector<uint8_t> flags;
+	std::vector<int> dirty; //Each changed model once, in the order it first changed.
+};